@@ -29,12 +29,35 @@ CREATE TABLE borrowing_records (
     borrow_date TIMESTAMP WITH TIME ZONE DEFAULT CURRENT_TIMESTAMP,
     due_date TIMESTAMP WITH TIME ZONE NOT NULL,
     return_date TIMESTAMP WITH TIME ZONE,
-    status VARCHAR(20) NOT NULL DEFAULT 'borrowed',
+    status SMALLINT NOT NULL DEFAULT 0 CHECK (status BETWEEN 0 AND 3), -- 0 借出 1 已还 2 逾期 3 续借, 与 BORROWING_STATUS_* (statements.hpp) 一致
     created_at TIMESTAMP WITH TIME ZONE DEFAULT CURRENT_TIMESTAMP,
     updated_at TIMESTAMP WITH TIME ZONE DEFAULT CURRENT_TIMESTAMP
 );
 
 
+-- 目录计数: 由 books 上的触发器增量维护, 列表页读取总数不再 COUNT(*) 全表扫描.
+-- 每个分类拆成 16 个 slot (按后端进程号选择), 并发借还分散到不同行上, 不会互相等锁;
+-- 读取时对 slot 求和. category 为空串表示未分类
+CREATE TABLE catalog_counters (
+    category VARCHAR(50) NOT NULL,
+    slot SMALLINT NOT NULL,
+    books BIGINT NOT NULL DEFAULT 0,
+    total_copies BIGINT NOT NULL DEFAULT 0,
+    available_copies BIGINT NOT NULL DEFAULT 0,
+    PRIMARY KEY (category, slot)
+);
+
+
+-- 图书列表按 (title, id) 键集分页, 每页只扫描索引上的一小段
+CREATE INDEX idx_books_title_id ON books (title, id);
+
+-- 未归还的借阅按用户索引, 借阅数/逾期数 (含批量按用户分组统计) 只扫描未还记录
+CREATE INDEX idx_borrowing_active_user ON borrowing_records (user_id, due_date) WHERE return_date IS NULL;
+
+-- 逾期列表只看未还且状态为借出 (0) 的记录
+-- status = 0 即 BORROWING_STATUS_BORROWED, 须与 borrowing_find_overdue 的条件一致才能用上此索引
+CREATE INDEX idx_borrowing_overdue ON borrowing_records (due_date) WHERE return_date IS NULL AND status = 0;
+
 -- 创建一个函数，用于自动更新updated_at字段
 CREATE OR REPLACE FUNCTION update_updated_at_column()
 RETURNS TRIGGER AS $$
@@ -58,4 +81,212 @@ CREATE TRIGGER update_books_updated_at
 CREATE TRIGGER update_borrowing_records_updated_at
     BEFORE UPDATE ON borrowing_records
     FOR EACH ROW
-    EXECUTE FUNCTION update_updated_at_column();
\ No newline at end of file
+    EXECUTE FUNCTION update_updated_at_column();
+
+-- 按增量调整目录计数, 由 update_catalog_counters 调用
+CREATE OR REPLACE FUNCTION adjust_catalog_counters(
+    p_category VARCHAR(50),
+    p_books BIGINT,
+    p_total_copies BIGINT,
+    p_available_copies BIGINT
+)
+RETURNS VOID AS $$
+BEGIN
+    INSERT INTO catalog_counters AS c (category, slot, books, total_copies, available_copies)
+    VALUES (COALESCE(p_category, ''), pg_backend_pid() % 16, p_books, p_total_copies, p_available_copies)
+    ON CONFLICT (category, slot) DO UPDATE
+       SET books = c.books + EXCLUDED.books,
+           total_copies = c.total_copies + EXCLUDED.total_copies,
+           available_copies = c.available_copies + EXCLUDED.available_copies;
+END;
+$$ language 'plpgsql';
+
+CREATE OR REPLACE FUNCTION update_catalog_counters()
+RETURNS TRIGGER AS $$
+BEGIN
+    IF TG_OP = 'INSERT' THEN
+        PERFORM adjust_catalog_counters(NEW.category, 1, NEW.total_copies, NEW.available_copies);
+    ELSIF TG_OP = 'DELETE' THEN
+        PERFORM adjust_catalog_counters(OLD.category, -1, -OLD.total_copies, -OLD.available_copies);
+    ELSIF OLD.category IS NOT DISTINCT FROM NEW.category THEN
+        -- 借还只改 available_copies, 一次更新
+        PERFORM adjust_catalog_counters(NEW.category, 0,
+            NEW.total_copies - OLD.total_copies, NEW.available_copies - OLD.available_copies);
+    ELSE
+        PERFORM adjust_catalog_counters(OLD.category, -1, -OLD.total_copies, -OLD.available_copies);
+        PERFORM adjust_catalog_counters(NEW.category, 1, NEW.total_copies, NEW.available_copies);
+    END IF;
+    RETURN NULL;
+END;
+$$ language 'plpgsql';
+
+CREATE TRIGGER update_books_catalog_counters
+    AFTER INSERT OR DELETE ON books
+    FOR EACH ROW
+    EXECUTE FUNCTION update_catalog_counters();
+
+CREATE TRIGGER update_books_catalog_counters_on_update
+    AFTER UPDATE OF category, total_copies, available_copies ON books
+    FOR EACH ROW
+    WHEN (OLD.category IS DISTINCT FROM NEW.category
+       OR OLD.total_copies <> NEW.total_copies
+       OR OLD.available_copies <> NEW.available_copies)
+    EXECUTE FUNCTION update_catalog_counters();
+
+-- 缓存失效通知: 行提交后向 cache_invalidation 频道发送 "表名:id", 各实例的
+-- InvalidationListener 据此失效本地缓存. borrowing_records 发送 book_id (借还改变库存).
+-- books 的新增也通知: 新书改变目录页, 各实例的目录版本需要推进.
+-- 同一事务内相同的通知由 PostgreSQL 合并, 只在事务提交后送达.
+-- 批量导入 (SET LOCAL library.bulk_import = 'on') 不逐行通知, 提交时统一发送 "books:*"
+CREATE OR REPLACE FUNCTION notify_cache_invalidation()
+RETURNS TRIGGER AS $$
+DECLARE
+    v_row RECORD;
+BEGIN
+    IF current_setting('library.bulk_import', true) = 'on' THEN
+        RETURN NULL;
+    END IF;
+
+    IF TG_OP = 'DELETE' THEN
+        v_row := OLD;
+    ELSE
+        v_row := NEW;
+    END IF;
+
+    IF TG_TABLE_NAME = 'borrowing_records' THEN
+        PERFORM pg_notify('cache_invalidation', 'borrowing_records:' || v_row.book_id);
+    ELSE
+        PERFORM pg_notify('cache_invalidation', TG_TABLE_NAME || ':' || v_row.id);
+    END IF;
+    RETURN NULL;
+END;
+$$ language 'plpgsql';
+
+-- books 单独处理: 借还只改 available_copies, 这时发送 "book_availability:id",
+-- 各实例只丢弃库存条目, 保留元数据; 其他列变化才发送 "books:id" 失效整本书
+CREATE OR REPLACE FUNCTION notify_book_cache_invalidation()
+RETURNS TRIGGER AS $$
+BEGIN
+    IF current_setting('library.bulk_import', true) = 'on' THEN
+        RETURN NULL;
+    END IF;
+
+    IF TG_OP = 'DELETE' THEN
+        PERFORM pg_notify('cache_invalidation', 'books:' || OLD.id);
+    ELSIF TG_OP = 'INSERT' THEN
+        PERFORM pg_notify('cache_invalidation', 'books:' || NEW.id);
+    ELSIF (OLD.isbn, OLD.title, OLD.author, OLD.publisher, OLD.publish_date, OLD.category, OLD.total_copies)
+          IS DISTINCT FROM
+          (NEW.isbn, NEW.title, NEW.author, NEW.publisher, NEW.publish_date, NEW.category, NEW.total_copies) THEN
+        PERFORM pg_notify('cache_invalidation', 'books:' || NEW.id);
+    ELSIF OLD.available_copies <> NEW.available_copies THEN
+        PERFORM pg_notify('cache_invalidation', 'book_availability:' || NEW.id);
+    END IF;
+    RETURN NULL;
+END;
+$$ language 'plpgsql';
+
+CREATE TRIGGER notify_users_cache
+    AFTER UPDATE OR DELETE ON users
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_cache_invalidation();
+
+CREATE TRIGGER notify_books_cache
+    AFTER INSERT OR UPDATE OR DELETE ON books
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_book_cache_invalidation();
+
+CREATE TRIGGER notify_borrowing_records_cache
+    AFTER INSERT OR UPDATE OR DELETE ON borrowing_records
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_cache_invalidation();
+
+-- 借书: 一次调用完成校验、扣减库存和写入借阅记录
+-- 先锁住用户行, 同一用户的并发借书串行执行, 借阅上限和逾期校验不会被绕过;
+-- 库存以 available_copies > 0 为条件原子扣减, 不会超借.
+-- 总是返回一行: 成功时 refusal = 0, loan 为新借阅记录; 被拒绝时 loan 为 NULL,
+-- refusal 为原因, 不做任何修改. 取值与 BorrowRefusal (borrowing_record.hpp) 一致:
+--   1 用户不存在  2 图书不存在  3 无可借库存  4 达到借阅上限  5 有逾期未还  6 已借此书未还
+CREATE OR REPLACE FUNCTION borrow_book(
+    p_user_id INT,
+    p_book_id INT,
+    p_borrow_date TIMESTAMP WITH TIME ZONE,
+    p_due_date TIMESTAMP WITH TIME ZONE,
+    p_max_active INT,
+    OUT refusal SMALLINT,
+    OUT loan borrowing_records
+) AS $$
+DECLARE
+    v_active INT;
+    v_overdue INT;
+    v_duplicate BOOLEAN;
+BEGIN
+    PERFORM 1 FROM users WHERE id = p_user_id FOR UPDATE;
+    IF NOT FOUND THEN
+        refusal := 1;
+        RETURN;
+    END IF;
+
+    SELECT COUNT(*),
+           COUNT(*) FILTER (WHERE due_date < CURRENT_TIMESTAMP),
+           COALESCE(BOOL_OR(book_id = p_book_id), FALSE)
+      INTO v_active, v_overdue, v_duplicate
+      FROM borrowing_records
+     WHERE user_id = p_user_id AND return_date IS NULL;
+
+    IF v_duplicate THEN
+        refusal := 6;
+        RETURN;
+    END IF;
+    IF v_overdue > 0 THEN
+        refusal := 5;
+        RETURN;
+    END IF;
+    IF v_active >= p_max_active THEN
+        refusal := 4;
+        RETURN;
+    END IF;
+
+    UPDATE books SET available_copies = available_copies - 1
+     WHERE id = p_book_id AND available_copies > 0;
+    IF NOT FOUND THEN
+        refusal := CASE WHEN EXISTS (SELECT 1 FROM books WHERE id = p_book_id) THEN 3 ELSE 2 END;
+        RETURN;
+    END IF;
+
+    INSERT INTO borrowing_records (user_id, book_id, borrow_date, due_date, status)
+    VALUES (p_user_id, p_book_id, p_borrow_date, p_due_date, 0)  -- BORROWING_STATUS_BORROWED
+    RETURNING * INTO loan;
+    refusal := 0;
+END;
+$$ language 'plpgsql';
+
+-- 还书: 关闭该用户对该书未归还的借阅记录并归还库存, 没有未归还记录时返回空结果集
+CREATE OR REPLACE FUNCTION return_book(
+    p_user_id INT,
+    p_book_id INT,
+    p_return_date TIMESTAMP WITH TIME ZONE
+)
+RETURNS SETOF borrowing_records AS $$
+DECLARE
+    v_record borrowing_records;
+BEGIN
+    UPDATE borrowing_records SET return_date = p_return_date, status = 1  -- BORROWING_STATUS_RETURNED
+     WHERE id = (
+        SELECT id FROM borrowing_records
+         WHERE user_id = p_user_id AND book_id = p_book_id AND return_date IS NULL
+         ORDER BY borrow_date
+         LIMIT 1
+           FOR UPDATE
+     )
+    RETURNING * INTO v_record;
+    IF NOT FOUND THEN
+        RETURN;
+    END IF;
+
+    UPDATE books SET available_copies = available_copies + 1
+     WHERE id = p_book_id AND available_copies < total_copies;
+
+    RETURN NEXT v_record;
+END;
+$$ language 'plpgsql';
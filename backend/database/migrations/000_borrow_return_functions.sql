@@ -0,0 +1,97 @@
+-- 借还函数 borrow_book() / return_book(), BorrowingRecord::borrow / returnActive 调用.
+-- 连接池在建立连接时预编译 borrowing_borrow / borrowing_return_active, 函数不存在时
+-- 预编译失败, 连接无法建立; 升级到使用这两个函数的版本之前执行一次.
+-- 需在 001 之前执行: 此时 status 仍是 VARCHAR. 001 会改为写入整数状态;
+-- 已执行过 001 的库上函数已存在, 这里不做任何修改. 新库直接使用 init.sql
+
+BEGIN;
+
+DO $migration$
+BEGIN
+    IF to_regprocedure('borrow_book(integer, integer, timestamp with time zone, timestamp with time zone, integer)') IS NULL THEN
+        -- 借书: 一次调用完成校验、扣减库存和写入借阅记录
+        -- 先锁住用户行, 同一用户的并发借书串行执行, 借阅上限和逾期校验不会被绕过;
+        -- 库存以 available_copies > 0 为条件原子扣减, 不会超借.
+        -- 任一校验失败时返回空结果集, 不做任何修改
+        EXECUTE $function$
+        CREATE FUNCTION borrow_book(
+            p_user_id INT,
+            p_book_id INT,
+            p_borrow_date TIMESTAMP WITH TIME ZONE,
+            p_due_date TIMESTAMP WITH TIME ZONE,
+            p_max_active INT
+        )
+        RETURNS SETOF borrowing_records AS $$
+        DECLARE
+            v_active INT;
+            v_overdue INT;
+            v_duplicate BOOLEAN;
+        BEGIN
+            PERFORM 1 FROM users WHERE id = p_user_id FOR UPDATE;
+            IF NOT FOUND THEN
+                RETURN;
+            END IF;
+
+            SELECT COUNT(*),
+                   COUNT(*) FILTER (WHERE due_date < CURRENT_TIMESTAMP),
+                   COALESCE(BOOL_OR(book_id = p_book_id), FALSE)
+              INTO v_active, v_overdue, v_duplicate
+              FROM borrowing_records
+             WHERE user_id = p_user_id AND return_date IS NULL;
+
+            IF v_active >= p_max_active OR v_overdue > 0 OR v_duplicate THEN
+                RETURN;
+            END IF;
+
+            UPDATE books SET available_copies = available_copies - 1
+             WHERE id = p_book_id AND available_copies > 0;
+            IF NOT FOUND THEN
+                RETURN;
+            END IF;
+
+            RETURN QUERY
+            INSERT INTO borrowing_records (user_id, book_id, borrow_date, due_date, status)
+            VALUES (p_user_id, p_book_id, p_borrow_date, p_due_date, 'borrowed')
+            RETURNING *;
+        END;
+        $$ language 'plpgsql'
+        $function$;
+    END IF;
+
+    IF to_regprocedure('return_book(integer, integer, timestamp with time zone)') IS NULL THEN
+        -- 还书: 关闭该用户对该书未归还的借阅记录并归还库存, 没有未归还记录时返回空结果集
+        EXECUTE $function$
+        CREATE FUNCTION return_book(
+            p_user_id INT,
+            p_book_id INT,
+            p_return_date TIMESTAMP WITH TIME ZONE
+        )
+        RETURNS SETOF borrowing_records AS $$
+        DECLARE
+            v_record borrowing_records;
+        BEGIN
+            UPDATE borrowing_records SET return_date = p_return_date, status = 'returned'
+             WHERE id = (
+                SELECT id FROM borrowing_records
+                 WHERE user_id = p_user_id AND book_id = p_book_id AND return_date IS NULL
+                 ORDER BY borrow_date
+                 LIMIT 1
+                   FOR UPDATE
+             )
+            RETURNING * INTO v_record;
+            IF NOT FOUND THEN
+                RETURN;
+            END IF;
+
+            UPDATE books SET available_copies = available_copies + 1
+             WHERE id = p_book_id AND available_copies < total_copies;
+
+            RETURN NEXT v_record;
+        END;
+        $$ language 'plpgsql'
+        $function$;
+    END IF;
+END;
+$migration$;
+
+COMMIT;
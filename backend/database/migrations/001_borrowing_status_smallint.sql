@@ -0,0 +1,100 @@
+-- borrowing_records.status: VARCHAR(20) -> SMALLINT
+-- 编码与 BORROWING_STATUS_* (utils/statements.hpp) 一致: 0 borrowed, 1 returned, 2 overdue, 3 renewed
+-- 在已有数据库上执行一次; 新库直接使用 init.sql
+
+BEGIN;
+
+ALTER TABLE borrowing_records ALTER COLUMN status DROP DEFAULT;
+
+ALTER TABLE borrowing_records ALTER COLUMN status TYPE SMALLINT USING
+    CASE status
+        WHEN 'borrowed' THEN 0
+        WHEN 'returned' THEN 1
+        WHEN 'overdue' THEN 2
+        WHEN 'renewed' THEN 3
+    END;    -- 未知状态得到 NULL, NOT NULL 约束会让整个迁移回滚
+
+ALTER TABLE borrowing_records ALTER COLUMN status SET DEFAULT 0;
+ALTER TABLE borrowing_records ADD CONSTRAINT borrowing_records_status_check CHECK (status BETWEEN 0 AND 3);
+
+-- 逾期列表只看未还且状态为借出 (0) 的记录
+CREATE INDEX idx_borrowing_overdue ON borrowing_records (due_date) WHERE return_date IS NULL AND status = 0;
+
+-- 借还函数改为写入整数状态
+-- 借书: 一次调用完成校验、扣减库存和写入借阅记录
+-- 先锁住用户行, 同一用户的并发借书串行执行, 借阅上限和逾期校验不会被绕过;
+-- 库存以 available_copies > 0 为条件原子扣减, 不会超借.
+-- 任一校验失败时返回空结果集, 不做任何修改
+CREATE OR REPLACE FUNCTION borrow_book(
+    p_user_id INT,
+    p_book_id INT,
+    p_borrow_date TIMESTAMP WITH TIME ZONE,
+    p_due_date TIMESTAMP WITH TIME ZONE,
+    p_max_active INT
+)
+RETURNS SETOF borrowing_records AS $$
+DECLARE
+    v_active INT;
+    v_overdue INT;
+    v_duplicate BOOLEAN;
+BEGIN
+    PERFORM 1 FROM users WHERE id = p_user_id FOR UPDATE;
+    IF NOT FOUND THEN
+        RETURN;
+    END IF;
+
+    SELECT COUNT(*),
+           COUNT(*) FILTER (WHERE due_date < CURRENT_TIMESTAMP),
+           COALESCE(BOOL_OR(book_id = p_book_id), FALSE)
+      INTO v_active, v_overdue, v_duplicate
+      FROM borrowing_records
+     WHERE user_id = p_user_id AND return_date IS NULL;
+
+    IF v_active >= p_max_active OR v_overdue > 0 OR v_duplicate THEN
+        RETURN;
+    END IF;
+
+    UPDATE books SET available_copies = available_copies - 1
+     WHERE id = p_book_id AND available_copies > 0;
+    IF NOT FOUND THEN
+        RETURN;
+    END IF;
+
+    RETURN QUERY
+    INSERT INTO borrowing_records (user_id, book_id, borrow_date, due_date, status)
+    VALUES (p_user_id, p_book_id, p_borrow_date, p_due_date, 0)
+    RETURNING *;
+END;
+$$ language 'plpgsql';
+
+-- 还书: 关闭该用户对该书未归还的借阅记录并归还库存, 没有未归还记录时返回空结果集
+CREATE OR REPLACE FUNCTION return_book(
+    p_user_id INT,
+    p_book_id INT,
+    p_return_date TIMESTAMP WITH TIME ZONE
+)
+RETURNS SETOF borrowing_records AS $$
+DECLARE
+    v_record borrowing_records;
+BEGIN
+    UPDATE borrowing_records SET return_date = p_return_date, status = 1
+     WHERE id = (
+        SELECT id FROM borrowing_records
+         WHERE user_id = p_user_id AND book_id = p_book_id AND return_date IS NULL
+         ORDER BY borrow_date
+         LIMIT 1
+           FOR UPDATE
+     )
+    RETURNING * INTO v_record;
+    IF NOT FOUND THEN
+        RETURN;
+    END IF;
+
+    UPDATE books SET available_copies = available_copies + 1
+     WHERE id = p_book_id AND available_copies < total_copies;
+
+    RETURN NEXT v_record;
+END;
+$$ language 'plpgsql';
+
+COMMIT;
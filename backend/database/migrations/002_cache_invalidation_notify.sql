@@ -0,0 +1,44 @@
+-- 缓存失效通知触发器, 配合 InvalidationListener (DB_NOTIFY_CHANNEL = cache_invalidation)
+-- 在已有数据库上执行一次; 新库直接使用 init.sql
+
+BEGIN;
+
+-- 缓存失效通知: 行提交后向 cache_invalidation 频道发送 "表名:id", 各实例的
+-- InvalidationListener 据此失效本地缓存. borrowing_records 发送 book_id (借还改变库存).
+-- 同一事务内相同的通知由 PostgreSQL 合并, 只在事务提交后送达
+CREATE OR REPLACE FUNCTION notify_cache_invalidation()
+RETURNS TRIGGER AS $$
+DECLARE
+    v_row RECORD;
+BEGIN
+    IF TG_OP = 'DELETE' THEN
+        v_row := OLD;
+    ELSE
+        v_row := NEW;
+    END IF;
+
+    IF TG_TABLE_NAME = 'borrowing_records' THEN
+        PERFORM pg_notify('cache_invalidation', 'borrowing_records:' || v_row.book_id);
+    ELSE
+        PERFORM pg_notify('cache_invalidation', TG_TABLE_NAME || ':' || v_row.id);
+    END IF;
+    RETURN NULL;
+END;
+$$ language 'plpgsql';
+
+CREATE TRIGGER notify_users_cache
+    AFTER UPDATE OR DELETE ON users
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_cache_invalidation();
+
+CREATE TRIGGER notify_books_cache
+    AFTER UPDATE OR DELETE ON books
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_cache_invalidation();
+
+CREATE TRIGGER notify_borrowing_records_cache
+    AFTER INSERT OR UPDATE OR DELETE ON borrowing_records
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_cache_invalidation();
+
+COMMIT;
@@ -0,0 +1,75 @@
+-- 目录计数表和维护触发器; 在已有数据库上执行一次, 新库直接使用 init.sql
+
+BEGIN;
+
+-- 目录计数: 由 books 上的触发器增量维护, 列表页读取总数不再 COUNT(*) 全表扫描.
+-- 每个分类拆成 16 个 slot (按后端进程号选择), 并发借还分散到不同行上, 不会互相等锁;
+-- 读取时对 slot 求和. category 为空串表示未分类
+CREATE TABLE catalog_counters (
+    category VARCHAR(50) NOT NULL,
+    slot SMALLINT NOT NULL,
+    books BIGINT NOT NULL DEFAULT 0,
+    total_copies BIGINT NOT NULL DEFAULT 0,
+    available_copies BIGINT NOT NULL DEFAULT 0,
+    PRIMARY KEY (category, slot)
+);
+
+-- 按增量调整目录计数, 由 update_catalog_counters 调用
+CREATE OR REPLACE FUNCTION adjust_catalog_counters(
+    p_category VARCHAR(50),
+    p_books BIGINT,
+    p_total_copies BIGINT,
+    p_available_copies BIGINT
+)
+RETURNS VOID AS $$
+BEGIN
+    INSERT INTO catalog_counters AS c (category, slot, books, total_copies, available_copies)
+    VALUES (COALESCE(p_category, ''), pg_backend_pid() % 16, p_books, p_total_copies, p_available_copies)
+    ON CONFLICT (category, slot) DO UPDATE
+       SET books = c.books + EXCLUDED.books,
+           total_copies = c.total_copies + EXCLUDED.total_copies,
+           available_copies = c.available_copies + EXCLUDED.available_copies;
+END;
+$$ language 'plpgsql';
+
+CREATE OR REPLACE FUNCTION update_catalog_counters()
+RETURNS TRIGGER AS $$
+BEGIN
+    IF TG_OP = 'INSERT' THEN
+        PERFORM adjust_catalog_counters(NEW.category, 1, NEW.total_copies, NEW.available_copies);
+    ELSIF TG_OP = 'DELETE' THEN
+        PERFORM adjust_catalog_counters(OLD.category, -1, -OLD.total_copies, -OLD.available_copies);
+    ELSIF OLD.category IS NOT DISTINCT FROM NEW.category THEN
+        -- 借还只改 available_copies, 一次更新
+        PERFORM adjust_catalog_counters(NEW.category, 0,
+            NEW.total_copies - OLD.total_copies, NEW.available_copies - OLD.available_copies);
+    ELSE
+        PERFORM adjust_catalog_counters(OLD.category, -1, -OLD.total_copies, -OLD.available_copies);
+        PERFORM adjust_catalog_counters(NEW.category, 1, NEW.total_copies, NEW.available_copies);
+    END IF;
+    RETURN NULL;
+END;
+$$ language 'plpgsql';
+
+CREATE TRIGGER update_books_catalog_counters
+    AFTER INSERT OR DELETE ON books
+    FOR EACH ROW
+    EXECUTE FUNCTION update_catalog_counters();
+
+CREATE TRIGGER update_books_catalog_counters_on_update
+    AFTER UPDATE OF category, total_copies, available_copies ON books
+    FOR EACH ROW
+    WHEN (OLD.category IS DISTINCT FROM NEW.category
+       OR OLD.total_copies <> NEW.total_copies
+       OR OLD.available_copies <> NEW.available_copies)
+    EXECUTE FUNCTION update_catalog_counters();
+
+-- 以现有数据初始化; 锁住 books 的写入, 计数与触发器接管之间不会漏掉变更
+LOCK TABLE books IN SHARE MODE;
+
+INSERT INTO catalog_counters (category, slot, books, total_copies, available_copies)
+SELECT COALESCE(category, ''), 0, COUNT(*), SUM(total_copies), SUM(available_copies)
+  FROM books
+ GROUP BY COALESCE(category, '');
+
+COMMIT;
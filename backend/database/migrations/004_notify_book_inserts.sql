@@ -0,0 +1,13 @@
+-- 新增图书也发送缓存失效通知, 让各实例推进目录版本 (响应缓存随之失效)
+-- 在已有数据库上执行一次; 新库直接使用 init.sql
+
+BEGIN;
+
+DROP TRIGGER IF EXISTS notify_books_cache ON books;
+
+CREATE TRIGGER notify_books_cache
+    AFTER INSERT OR UPDATE OR DELETE ON books
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_cache_invalidation();
+
+COMMIT;
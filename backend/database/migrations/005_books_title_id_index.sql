@@ -0,0 +1,6 @@
+-- 图书列表按 (title, id) 键集分页 (Book::findPage) 的索引; 没有它每页都要排序全表
+-- 在已有数据库上执行一次; 新库直接使用 init.sql
+-- CONCURRENTLY 不阻塞 books 的写入, 但不能放在事务里执行;
+-- 中途失败会留下 INVALID 索引, IF NOT EXISTS 会跳过它, 需先 DROP INDEX 再重新执行
+
+CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_books_title_id ON books (title, id);
@@ -0,0 +1,30 @@
+-- 批量导入期间不逐行发送缓存失效通知 (BookImport 提交时统一发送 "books:*")
+-- 在已有数据库上执行一次; 新库直接使用 init.sql
+
+BEGIN;
+
+CREATE OR REPLACE FUNCTION notify_cache_invalidation()
+RETURNS TRIGGER AS $$
+DECLARE
+    v_row RECORD;
+BEGIN
+    IF current_setting('library.bulk_import', true) = 'on' THEN
+        RETURN NULL;
+    END IF;
+
+    IF TG_OP = 'DELETE' THEN
+        v_row := OLD;
+    ELSE
+        v_row := NEW;
+    END IF;
+
+    IF TG_TABLE_NAME = 'borrowing_records' THEN
+        PERFORM pg_notify('cache_invalidation', 'borrowing_records:' || v_row.book_id);
+    ELSE
+        PERFORM pg_notify('cache_invalidation', TG_TABLE_NAME || ':' || v_row.id);
+    END IF;
+    RETURN NULL;
+END;
+$$ language 'plpgsql';
+
+COMMIT;
@@ -0,0 +1,7 @@
+-- 未归还借阅按用户的部分索引, 借阅数/逾期数 (含按用户批量分组统计) 只扫描未还记录
+-- 在已有数据库上执行一次; 新库直接使用 init.sql
+-- CONCURRENTLY 不阻塞借还写入, 但不能放在事务里执行;
+-- 中途失败会留下 INVALID 索引, IF NOT EXISTS 会跳过它, 需先 DROP INDEX 再重新执行
+
+CREATE INDEX CONCURRENTLY IF NOT EXISTS idx_borrowing_active_user
+    ON borrowing_records (user_id, due_date) WHERE return_date IS NULL;
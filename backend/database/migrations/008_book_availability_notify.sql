@@ -0,0 +1,38 @@
+-- 借还只改 books.available_copies 时发送 "book_availability:id" 而不是 "books:id",
+-- 各实例只丢弃库存条目, 不再因每次借还失效整本书 (元数据和 ISBN 索引)
+-- 在已有数据库上执行一次; 新库直接使用 init.sql
+
+BEGIN;
+
+-- books 单独处理: 借还只改 available_copies, 这时发送 "book_availability:id",
+-- 各实例只丢弃库存条目, 保留元数据; 其他列变化才发送 "books:id" 失效整本书
+CREATE OR REPLACE FUNCTION notify_book_cache_invalidation()
+RETURNS TRIGGER AS $$
+BEGIN
+    IF current_setting('library.bulk_import', true) = 'on' THEN
+        RETURN NULL;
+    END IF;
+
+    IF TG_OP = 'DELETE' THEN
+        PERFORM pg_notify('cache_invalidation', 'books:' || OLD.id);
+    ELSIF TG_OP = 'INSERT' THEN
+        PERFORM pg_notify('cache_invalidation', 'books:' || NEW.id);
+    ELSIF (OLD.isbn, OLD.title, OLD.author, OLD.publisher, OLD.publish_date, OLD.category, OLD.total_copies)
+          IS DISTINCT FROM
+          (NEW.isbn, NEW.title, NEW.author, NEW.publisher, NEW.publish_date, NEW.category, NEW.total_copies) THEN
+        PERFORM pg_notify('cache_invalidation', 'books:' || NEW.id);
+    ELSIF OLD.available_copies <> NEW.available_copies THEN
+        PERFORM pg_notify('cache_invalidation', 'book_availability:' || NEW.id);
+    END IF;
+    RETURN NULL;
+END;
+$$ language 'plpgsql';
+
+DROP TRIGGER IF EXISTS notify_books_cache ON books;
+
+CREATE TRIGGER notify_books_cache
+    AFTER INSERT OR UPDATE OR DELETE ON books
+    FOR EACH ROW
+    EXECUTE FUNCTION notify_book_cache_invalidation();
+
+COMMIT;
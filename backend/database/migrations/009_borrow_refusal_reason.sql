@@ -0,0 +1,70 @@
+-- borrow_book() 改为总是返回一行 (refusal, loan), 被拒绝时在同一次调用中带回原因,
+-- 服务端不再为说明拒绝原因额外查询; 与读取 refusal 列的新版本一同部署.
+-- 返回类型改变, 不能 CREATE OR REPLACE, 先删除旧函数 (需在 000 和 001 之后执行)
+-- 在已有数据库上执行一次; 新库直接使用 init.sql
+
+BEGIN;
+
+DROP FUNCTION IF EXISTS borrow_book(integer, integer, timestamp with time zone, timestamp with time zone, integer);
+
+-- 借书: 一次调用完成校验、扣减库存和写入借阅记录
+-- 先锁住用户行, 同一用户的并发借书串行执行, 借阅上限和逾期校验不会被绕过;
+-- 库存以 available_copies > 0 为条件原子扣减, 不会超借.
+-- 总是返回一行: 成功时 refusal = 0, loan 为新借阅记录; 被拒绝时 loan 为 NULL,
+-- refusal 为原因, 不做任何修改. 取值与 BorrowRefusal (borrowing_record.hpp) 一致:
+--   1 用户不存在  2 图书不存在  3 无可借库存  4 达到借阅上限  5 有逾期未还  6 已借此书未还
+CREATE FUNCTION borrow_book(
+    p_user_id INT,
+    p_book_id INT,
+    p_borrow_date TIMESTAMP WITH TIME ZONE,
+    p_due_date TIMESTAMP WITH TIME ZONE,
+    p_max_active INT,
+    OUT refusal SMALLINT,
+    OUT loan borrowing_records
+) AS $$
+DECLARE
+    v_active INT;
+    v_overdue INT;
+    v_duplicate BOOLEAN;
+BEGIN
+    PERFORM 1 FROM users WHERE id = p_user_id FOR UPDATE;
+    IF NOT FOUND THEN
+        refusal := 1;
+        RETURN;
+    END IF;
+
+    SELECT COUNT(*),
+           COUNT(*) FILTER (WHERE due_date < CURRENT_TIMESTAMP),
+           COALESCE(BOOL_OR(book_id = p_book_id), FALSE)
+      INTO v_active, v_overdue, v_duplicate
+      FROM borrowing_records
+     WHERE user_id = p_user_id AND return_date IS NULL;
+
+    IF v_duplicate THEN
+        refusal := 6;
+        RETURN;
+    END IF;
+    IF v_overdue > 0 THEN
+        refusal := 5;
+        RETURN;
+    END IF;
+    IF v_active >= p_max_active THEN
+        refusal := 4;
+        RETURN;
+    END IF;
+
+    UPDATE books SET available_copies = available_copies - 1
+     WHERE id = p_book_id AND available_copies > 0;
+    IF NOT FOUND THEN
+        refusal := CASE WHEN EXISTS (SELECT 1 FROM books WHERE id = p_book_id) THEN 3 ELSE 2 END;
+        RETURN;
+    END IF;
+
+    INSERT INTO borrowing_records (user_id, book_id, borrow_date, due_date, status)
+    VALUES (p_user_id, p_book_id, p_borrow_date, p_due_date, 0)  -- BORROWING_STATUS_BORROWED
+    RETURNING * INTO loan;
+    refusal := 0;
+END;
+$$ language 'plpgsql';
+
+COMMIT;
@@ -1,10 +1,15 @@
 // include/controller/book_controller.hpp
 
 #include <nlohmann/json_fwd.hpp>
+#include <functional>
 #include <string>
 #include <nlohmann/json.hpp>
 #include "models/book.hpp"
 #include "services/book_service.hpp"
+#include "utils/response_cache.hpp"
+
+#define RESPONSE_CACHE_CAPACITY 1024    // 缓存的已序列化响应条数
+#define RESPONSE_CACHE_SHARDS 8
 
 class BookController {
 public:
@@ -13,7 +18,8 @@ public:
         return instance;
     }
     
-    nlohmann::json handleGetAllBooks(const std::string& page, const std::string& pageSize);
+    // cursor: nextCursor from the previous response, empty for the first page
+    nlohmann::json handleGetAllBooks(const std::string& cursor, const std::string& pageSize);
     nlohmann::json handleGetBook(const std::string& book_id);
     nlohmann::json handleSearchBook(const std::string& keyword);
     nlohmann::json handleAddBook(const nlohmann::json& book_data);
@@ -22,10 +28,28 @@ public:
     nlohmann::json handleBorrowBook(const std::string& user_id, const std::string& book_id);
     nlohmann::json handleReturnBook(const std::string& user_id, const std::string& book_id);
     nlohmann::json handleGetBorrowedBooks(const std::string& user_id);
+    nlohmann::json handleGetCatalogStats();
+
+    /*
+    Cached variants of the catalog list and search: the serialized body is reused
+    until the catalog version moves. if_none_match is the request's If-None-Match
+    header; a matching ETag gives status 304 and no body. Bodies are built
+    from the primary even when a read replica is configured, so replica lag
+    can't leave a stale body cached under a newer catalog version.
+    */
+    SerializedResponse handleGetAllBooksCached(const std::string& cursor, const std::string& pageSize,
+                                               const std::string& if_none_match = "");
+    SerializedResponse handleSearchBookCached(const std::string& keyword, const std::string& if_none_match = "");
+
+    [[nodiscard]] CacheStats responseCacheStats() const { return responseCache_.stats(); }
 private:
     BookController() = default;
     BookController(const BookController&) = delete;
     BookController& operator=(const BookController&) = delete;
     
     BookService& bookService_ = BookService::getInstance();
+    ResponseCache responseCache_{RESPONSE_CACHE_CAPACITY, RESPONSE_CACHE_SHARDS};
+
+    SerializedResponse cachedResponse(const std::string& key, const std::string& if_none_match,
+                                      const std::function<nlohmann::json()>& build);
 };
\ No newline at end of file
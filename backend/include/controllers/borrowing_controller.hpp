@@ -6,6 +6,9 @@
 #include "models/borrowing_record.hpp"
 #include "services/borrowing_service.hpp"
 
+// 借阅状态的对外名称 ("borrowed", "returned", "overdue", "renewed"), 只在 JSON 序列化时使用
+const char* borrowingStatusName(BorrowingRecord::Status status);
+
 class BorrowingController {
 public:
     static BorrowingController& getInstance(){
@@ -22,6 +25,8 @@ public:
     nlohmann::json handleGetOverdueBooks();
 
     nlohmann::json handleGetUserBorrowStatus(const std::string& user_id);
+    // {"user_ids": [1, 2, ...]}, 最多 MAX_STATUS_BATCH 个, 一次查询返回所有用户的状态
+    nlohmann::json handleGetUserBorrowStatuses(const nlohmann::json& request);
 private:
     BorrowingController() = default;
     BorrowingController(const BorrowingController&) = delete;
@@ -32,4 +37,5 @@ private:
     nlohmann::json createSuccessResponse(const std::string& message, const nlohmann::json& data = nullptr);
     nlohmann::json createErrorResponse(const std::string& message);
     nlohmann::json borrowingRecordToJson(const BorrowingRecord* record);
+    nlohmann::json borrowingRowToJson(const BorrowingRow& record);
 };
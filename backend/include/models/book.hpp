@@ -3,9 +3,58 @@
 #pragma once
 #include <stdexcept>
 #include <string>
+#include <functional>
+#include <future>
 #include <memory>
+#include <ostream>
 #include <vector>
 #include <pqxx/pqxx>
+#include "utils/export_writer.hpp"
+#include "utils/page_cursor.hpp"
+#include "utils/result_set.hpp"
+#include "utils/statements.hpp"
+
+class AsyncResult;
+class BookCache;
+
+/*
+Read-only book row for list pages, strings point into the owning BookList
+*/
+struct BookRow {
+    int id{0};
+    std::string_view isbn;
+    std::string_view title;
+    std::string_view author;
+    std::string_view publisher;
+    std::string_view publish_date;
+    std::string_view category;
+    int total_copies{0};
+    int available_copies{0};
+};
+
+#define BOOK_ROW_MEMBER(column) , &BookRow::column
+template <>
+struct ModelTraits<BookRow> {
+    static constexpr auto members = std::make_tuple(&BookRow::id BOOK_COLUMNS(BOOK_ROW_MEMBER));
+};
+#undef BOOK_ROW_MEMBER
+
+using BookList = ResultSet<BookRow>;
+
+// 目录计数, 来自触发器维护的 catalog_counters 表; 未分类的 category 为空串
+struct CategoryCount {
+    std::string category;
+    long books{0};
+    long total_copies{0};
+    long available_copies{0};
+};
+
+struct CatalogCounters {
+    long books{0};
+    long total_copies{0};
+    long available_copies{0};
+    std::vector<CategoryCount> categories;
+};
 
 class Book{
 public:
@@ -69,11 +118,30 @@ public:
         return {};
     }
 
+    // Served from BookCache when both metadata and availability are cached
     static std::unique_ptr<Book> findById(int book_id);
     static std::unique_ptr<Book> findByIsbn(const std::string &isbn);
-    static std::vector<std::unique_ptr<Book>> findAll(int page, int pagesize);
-    static int count();
-    static std::vector<std::unique_ptr<Book>> search(const std::string& keyword);
+    // Keyset page ordered by (title, id), starting after `after`; a default cursor starts at the top
+    static BookList findPage(const PageCursor& after, int limit);
+    static int count();     // read from catalog_counters, not COUNT(*)
+    static CatalogCounters counters();
+    static BookList search(const std::string& keyword);
+
+    /*
+    Visit every book in id order, STREAM_BATCH_SIZE rows at a time with bounded memory.
+    callback returns false to stop early. Returns the number of rows visited, -1 on error.
+    */
+    static long forEach(const std::function<bool(const BookList& batch)>& callback);
+
+    // Stream the whole catalog to out in id order; returns rows written, -1 on error
+    static long exportTo(std::ostream& out, ExportFormat format, ExportCompression compression);
+
+    // Build a Book from a full `books` row, for queries run by other models
+    static std::unique_ptr<Book> fromRow(const pqxx::row& row);
+
+    // Non-blocking variants, run on AsyncExecutor; nullptr if not found
+    static std::future<std::unique_ptr<Book>> findByIdAsync(int book_id);
+    static std::future<std::unique_ptr<Book>> findByIsbnAsync(const std::string& isbn);
 
     bool save();
     bool update();
@@ -104,4 +172,7 @@ private:
 
     Book() =default;
     friend class BookBuilder;
+    friend class BookCache;
+    friend struct ModelTraits<Book>;
+    friend class RowMapper<Book>;
 };
@@ -0,0 +1,107 @@
+// include/models/book_cache.hpp
+
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "models/book.hpp"
+#include "utils/lru_cache.hpp"
+
+#define BOOK_CACHE_CAPACITY 50000   // 缓存的图书条数上限 (元数据、库存、ISBN 索引各自独立计数)
+#define BOOK_CACHE_SHARDS 16
+#define BOOK_CACHE_VERSION_STRIPES 4096 // 每本书的失效序号按 id 散列到这么多个槽
+
+struct BookCacheStats {
+    std::uint64_t hits{0};      // findById / findByIsbn 完全命中, 未访问数据库
+    std::uint64_t misses{0};
+    CacheStats metadata;
+    CacheStats availability;
+    CacheStats isbn_index;
+};
+
+/*
+进程内图书缓存, 供 Book::findById / findByIsbn 使用.
+
+图书元数据 (isbn, title, ...) 几乎不变, available_copies 随每次借还变化,
+两者分开缓存: 库存的写入和失效不会把元数据挤出缓存. 两部分都命中才算命中.
+
+写路径 (Book::save / update / remove / borrow / return_book, 借还函数, 批量导入)
+在提交后失效对应条目; 其他实例的写入通过 InvalidationListener
+(books / book_availability / borrowing_records 通知) 批量失效.
+
+每次失效取一个全局递增的序号, 记在该书 id 所在的槽上. 回填时带上查询前取得的
+generation(); 该书的槽在此之后被标记过就放弃回填. 检查和写入在分片锁内完成,
+失效先标记再删除, 所以旧行不会覆盖新值. 其他书的借还不影响这本书的回填.
+*/
+class BookCache {
+public:
+    static BookCache& getInstance(){
+        static BookCache instance;
+        return instance;
+    }
+
+    BookCache(const BookCache&) = delete;
+    ~BookCache();
+    BookCache& operator=(const BookCache&) = delete;
+
+    // nullptr on a miss
+    std::unique_ptr<Book> findById(int book_id);
+    std::unique_ptr<Book> findByIsbn(const std::string& isbn);
+
+    // 读取数据库之前调用, 回填时传给 put()
+    [[nodiscard]] std::uint64_t generation() const { return sequence_.load(std::memory_order_acquire); }
+
+    /*
+    目录版本: 本实例或其他实例 (经 NOTIFY) 每次改动图书或库存都会推进,
+    用于判断由目录数据生成的结果 (如 BookController 的响应缓存) 是否过期
+    */
+    [[nodiscard]] std::uint64_t catalogVersion() const { return generation(); }
+
+    // 回填查询结果, 这本书在 seen_generation 之后失效过则忽略
+    void put(const Book& book, std::uint64_t seen_generation);
+
+    // 新增图书 (Book::save): 推进版本后写入
+    void insert(const Book& book);
+
+    void invalidate(int book_id);                  // 元数据、库存和 ISBN 索引
+    void invalidateAvailability(int book_id);
+    void clear();
+
+    [[nodiscard]] BookCacheStats stats() const;
+
+private:
+    BookCache();
+
+    struct Metadata {
+        int id{0};
+        std::string isbn;
+        std::string title;
+        std::string author;
+        std::string publisher;
+        std::string publish_date;
+        std::string category;
+        int total_copies{0};
+    };
+
+    // 取一个新序号并记到 book_id 的槽上, 返回该序号
+    std::uint64_t mark(int book_id);
+    // book_id 在 seen_generation 之后没有失效过 (包括 clear)
+    [[nodiscard]] bool unchangedSince(int book_id, std::uint64_t seen_generation) const;
+    static std::size_t stripe(int book_id) {
+        return static_cast<std::size_t>(static_cast<unsigned int>(book_id)) % BOOK_CACHE_VERSION_STRIPES;
+    }
+
+    ShardedLruCache<int, std::shared_ptr<const Metadata>> metadata_;
+    ShardedLruCache<int, int> availability_;
+    ShardedLruCache<std::string, int> isbn_index_;
+
+    std::atomic<std::uint64_t> sequence_{0};
+    std::array<std::atomic<std::uint64_t>, BOOK_CACHE_VERSION_STRIPES> invalidated_at_{};   // 各槽最近一次失效的序号
+    std::atomic<std::uint64_t> cleared_at_{0};
+    std::vector<int> subscriptions_;    // InvalidationListener
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+};
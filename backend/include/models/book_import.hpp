@@ -0,0 +1,52 @@
+// include/models/book_import.hpp
+
+#pragma once
+#include <optional>
+#include <string>
+#include <pqxx/pqxx>
+#include "utils/database_pool.hpp"
+
+// 一条待导入的图书, 已通过校验
+struct ImportedBook {
+    std::string isbn;
+    std::string title;
+    std::string author;
+    std::string publisher;      // 空串写为 NULL
+    std::string publish_date;   // YYYY-MM-DD, 空串写为 NULL
+    std::string category;       // 空串写为 NULL
+    int total_copies{1};
+};
+
+/*
+Bulk load of the books catalog in a single transaction.
+
+write() streams rows into a temporary staging table over COPY
+(pqxx::stream_to), commit() merges the staging table into books with one
+INSERT ... ON CONFLICT (isbn) DO UPDATE. Destroying an uncommitted
+BookImport rolls everything back, staging table included.
+The per-row cache notifications of the merge are suppressed; commit()
+sends a single "books:*" instead.
+
+ISBNs must be unique within one import; BookService::importBooks dedupes them.
+*/
+class BookImport {
+public:
+    struct Result {
+        long inserted{0};
+        long updated{0};
+    };
+
+    BookImport();   // throws pqxx exceptions if the staging table cannot be created
+    BookImport(const BookImport&) = delete;
+    BookImport& operator=(const BookImport&) = delete;
+
+    void write(const ImportedBook& book);
+
+    // Finish the COPY, merge and commit
+    Result commit();
+
+private:
+    PooledConnection conn_;
+    pqxx::work txn_;
+    std::optional<pqxx::stream_to> stream_;
+};
@@ -1,11 +1,119 @@
 // include/models/borrowing_record.hpp
 
 #pragma once
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <vector>
+#include <unordered_map>
 #include <chrono>
+#include <future>
+#include <optional>
+#include <ostream>
 #include <pqxx/pqxx>
+#include "models/book.hpp"
+#include "utils/cursor_scan.hpp"
+#include "utils/export_writer.hpp"
+#include "utils/statements.hpp"
+#include "utils/timestamp.hpp"
+
+class AsyncResult;
+
+/*
+借阅状态, 数据库中存为 SMALLINT (取值即枚举值), 只在序列化为 JSON 时转成字符串.
+取值定义在 utils/statements.hpp (BORROWING_STATUS_*), 与预编译语句共用
+*/
+enum class BorrowingStatus : std::int16_t {
+    BORROWED = BORROWING_STATUS_BORROWED,   // 已借出
+    RETURNED = BORROWING_STATUS_RETURNED,   // 已归还
+    OVERDUE = BORROWING_STATUS_OVERDUE,     // 已逾期
+    RENEWED = BORROWING_STATUS_RENEWED      // 已续借
+};
+
+/*
+借书被拒绝的原因, 由数据库函数 borrow_book() 的 refusal 列返回 (取值即枚举值)
+*/
+enum class BorrowRefusal : std::int16_t {
+    NONE = 0,                   // 借阅成功
+    USER_NOT_FOUND = 1,
+    BOOK_NOT_FOUND = 2,
+    NO_COPIES_AVAILABLE = 3,
+    BORROW_LIMIT_REACHED = 4,
+    HAS_OVERDUE = 5,
+    ALREADY_BORROWED = 6,       // 该用户已借此书且未归还
+    DATABASE_ERROR = -1         // 仅客户端使用: 查询失败
+};
+
+template <>
+struct FieldReader<BorrowingStatus> {
+    static BorrowingStatus read(const pqxx::field& field) {
+        return static_cast<BorrowingStatus>(field.is_null() ? 0 : field.as<int>());
+    }
+
+    static BorrowingStatus parse(std::string_view text) {
+        return static_cast<BorrowingStatus>(FieldReader<int>::parse(text));
+    }
+};
+
+// 借阅记录只读行, 用于逾期列表等批量结果; 日期已解析为 Timestamp, 不引用 BorrowingList 的内存
+struct BorrowingRow {
+    int id{0};
+    int user_id{0};
+    int book_id{0};
+    Timestamp borrow_date;
+    Timestamp due_date;
+    std::optional<Timestamp> return_date;     // 未归还时为空
+    BorrowingStatus status{BorrowingStatus::BORROWED};
+};
+
+#define BORROWING_ROW_MEMBER(column) , &BorrowingRow::column
+template <>
+struct ModelTraits<BorrowingRow> {
+    static constexpr auto members = std::make_tuple(&BorrowingRow::id BORROWING_COLUMNS(BORROWING_ROW_MEMBER));
+};
+#undef BORROWING_ROW_MEMBER
+
+using BorrowingList = ResultSet<BorrowingRow>;
+
+/*
+未归还的借阅连同图书信息, 由一条 JOIN 查询取回 ("我的借阅" 页面);
+成员顺序: 借阅记录的列, 然后是图书的列 (图书 id 即 book_id)
+*/
+struct LoanRow {
+    int id{0};                              // 借阅记录 id
+    int user_id{0};
+    int book_id{0};
+    Timestamp borrow_date;
+    Timestamp due_date;
+    std::optional<Timestamp> return_date;
+    BorrowingStatus status{BorrowingStatus::BORROWED};
+    std::string_view isbn;
+    std::string_view title;
+    std::string_view author;
+    std::string_view publisher;
+    std::string_view publish_date;
+    std::string_view category;
+    int total_copies{0};
+    int available_copies{0};
+};
+
+#define LOAN_ROW_MEMBER(column) , &LoanRow::column
+template <>
+struct ModelTraits<LoanRow> {
+    static constexpr auto members = std::make_tuple(
+        &LoanRow::id BORROWING_COLUMNS(LOAN_ROW_MEMBER) BOOK_COLUMNS(LOAN_ROW_MEMBER));
+};
+#undef LOAN_ROW_MEMBER
+
+using LoanList = ResultSet<LoanRow>;
+
+// 批量扫描借阅记录的过滤条件, 0 / false 表示不过滤
+struct BorrowingFilter {
+    int user_id{0};
+    int book_id{0};
+    bool active_only{false};    // 未归还
+    bool overdue_only{false};   // 未归还且已过期
+};
 
 /*
 基础CRUD操作：
@@ -14,6 +122,7 @@ findById：根据ID查找借阅记录
 save：保存新的借阅记录
 update：更新借阅记录
 findByUserId：查找用户的所有借阅记录
+findActive：查找用户对某书未归还的借阅记录 (读主库, 用于据此写入的业务操作)
 findByBookId：查找图书的所有借阅记录
 
 
@@ -33,12 +142,7 @@ countOverdueByUserId：统计用户逾期数量
 class BorrowingRecord {
     public:
         // 借阅状态枚举
-        enum class Status {
-            BORROWED,   // 已借出
-            RETURNED,   // 已归还
-            OVERDUE,    // 已逾期
-            RENEWED     // 已续借
-        };
+        using Status = BorrowingStatus;
 
         class BorrowingRecordBuilder {
             public:
@@ -54,22 +158,22 @@ class BorrowingRecord {
                     return *this;
                 }
 
-                BorrowingRecordBuilder& setBorrowDate(const std::string& borrow_date) {
+                BorrowingRecordBuilder& setBorrowDate(Timestamp borrow_date) {
                     record_->borrow_date_ = borrow_date;
                     return *this;
                 }
 
-                BorrowingRecordBuilder& setDueDate(const std::string& due_date) {
+                BorrowingRecordBuilder& setDueDate(Timestamp due_date) {
                     record_->due_date_ = due_date;
                     return *this;
                 }
 
-                BorrowingRecordBuilder& setReturnDate(const std::string& return_date) {
+                BorrowingRecordBuilder& setReturnDate(Timestamp return_date) {
                     record_->return_date_ = return_date;
                     return *this;
                 }
 
-                BorrowingRecordBuilder& setStatus(const std::string& status) {
+                BorrowingRecordBuilder& setStatus(Status status) {
                     record_->status_ = status;
                     return *this;
                 }
@@ -78,7 +182,7 @@ class BorrowingRecord {
                     if (record_->user_id_ <= 0 || record_->book_id_ <= 0) {
                         throw std::invalid_argument("User ID and Book ID must be valid!");
                     }
-                    if (record_->borrow_date_.empty() || record_->due_date_.empty()) {
+                    if (record_->borrow_date_ == Timestamp{} || record_->due_date_ == Timestamp{}) {
                         throw std::invalid_argument("Borrow date and due date must be set!");
                     }
                     return std::move(record_);
@@ -95,42 +199,82 @@ class BorrowingRecord {
         // 查询方法
         static std::unique_ptr<BorrowingRecord> findById(int record_id);
         static std::vector<std::unique_ptr<BorrowingRecord>> findByUserId(int user_id);
+        static std::unique_ptr<BorrowingRecord> findActive(int user_id, int book_id);
         static std::vector<std::unique_ptr<BorrowingRecord>> findByBookId(int book_id);
-        static std::vector<std::unique_ptr<BorrowingRecord>> findOverdue();
+        static BorrowingList findOverdue();
+        static LoanList findActiveLoans(int user_id);   // 用户未归还的借阅及图书, 按应还日期排序
+
+        // 按 id 顺序流式遍历, 每次只取一批, 可直接用于 range-for
+        static CursorScan<BorrowingRow> scan(const BorrowingFilter& filter = {});
+
+        // 导出借阅历史, 按 borrow_date 过滤: [from, to), 空串表示不限; 返回行数, 出错返回-1
+        static long exportTo(std::ostream& out, ExportFormat format, ExportCompression compression,
+            const std::string& from = "", const std::string& to = "");
         static std::vector<std::unique_ptr<BorrowingRecord>> findAll();
 
         // 统计方法
         static int countActiveByUserId(int user_id);  // 获取用户当前借阅数量
         static int countOverdueByUserId(int user_id); // 获取用户逾期数量
 
+        // 非阻塞查询, 在 AsyncExecutor 上执行
+        static std::future<std::vector<std::unique_ptr<BorrowingRecord>>> findByUserIdAsync(int user_id);
+        static std::future<int> countActiveByUserIdAsync(int user_id);
+        static std::future<int> countOverdueByUserIdAsync(int user_id);
+
+        // 用户的借阅状态
+        struct BorrowStatus {
+            int active_count{0};    // 当前借阅数
+            int overdue_count{0};   // 逾期数
+        };
+
+        // 一次分组查询取回多个用户的借阅状态, 每个 id 都有结果 (无借阅为 0); 出错返回空表
+        static std::unordered_map<int, BorrowStatus> countStatusByUserIds(const std::vector<int>& user_ids);
+
+        // 借书结果: 成功时 record 非空, 否则 refusal 说明原因
+        struct BorrowResult {
+            std::unique_ptr<BorrowingRecord> record;
+            BorrowRefusal refusal{BorrowRefusal::DATABASE_ERROR};
+        };
+
         // CRUD操作
         bool save();
         bool update();
         bool remove();
 
+        // 原子借还: 校验、库存增减和借阅记录写入在数据库端一次完成.
+        // borrow 被拒绝时在同一次往返中带回原因; returnActive 失败返回nullptr
+        static BorrowResult borrow(int user_id, int book_id,
+            Timestamp borrow_date, Timestamp due_date, int max_active);
+        static std::unique_ptr<BorrowingRecord> returnActive(int user_id, int book_id,
+            Timestamp return_date);
+
         // 业务操作
-        bool return_book(const std::string& return_date);
+        bool return_book(Timestamp return_date);
         bool renew(); // 续借功能
-        [[nodiscard]] bool isOverdue() const; // 检查是否逾期
+        [[nodiscard]] bool isOverdue(Timestamp now) const; // 检查是否逾期, 在内存中比较 due_date
+        [[nodiscard]] bool isOverdue() const;
+        [[nodiscard]] bool isReturned() const { return return_date_.has_value(); }
 
         // Getters
         [[nodiscard]] int getId() const { return id_; }
         [[nodiscard]] int getUserId() const { return user_id_; }
         [[nodiscard]] int getBookId() const { return book_id_; }
-        [[nodiscard]] const std::string& getBorrowDate() const { return borrow_date_; }
-        [[nodiscard]] const std::string& getDueDate() const { return due_date_; }
-        [[nodiscard]] const std::string& getReturnDate() const { return return_date_; }
-        [[nodiscard]] const std::string& getStatus() const { return status_; }
+        [[nodiscard]] Timestamp getBorrowDate() const { return borrow_date_; }
+        [[nodiscard]] Timestamp getDueDate() const { return due_date_; }
+        [[nodiscard]] const std::optional<Timestamp>& getReturnDate() const { return return_date_; }
+        [[nodiscard]] Status getStatus() const { return status_; }
 
     private:
         int id_{0};
         int user_id_{0};
         int book_id_{0};
-        std::string borrow_date_;
-        std::string due_date_;
-        std::string return_date_;
-        std::string status_{"borrowed"};
+        Timestamp borrow_date_;
+        Timestamp due_date_;
+        std::optional<Timestamp> return_date_;
+        Status status_{Status::BORROWED};
 
         BorrowingRecord() = default;
         friend class BorrowingRecordBuilder;
+        friend struct ModelTraits<BorrowingRecord>;
+        friend class RowMapper<BorrowingRecord>;
 };
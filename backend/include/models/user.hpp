@@ -8,6 +8,9 @@
 #include <vector>
 #include <pqxx/pqxx>
 
+template <typename Model> struct ModelTraits;
+template <typename Model> class RowMapper;
+
 class User {
     public:
         class UserBuilder {
@@ -65,4 +68,6 @@ class User {
 
         User() = default;
         friend class UserBuilder;
+        friend struct ModelTraits<User>;
+        friend class RowMapper<User>;
     };
@@ -0,0 +1,102 @@
+// include/models/user_directory.hpp
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#define USER_DIRECTORY_RESERVE 1024     // 初始槽数 (2 的幂), 按需翻倍
+
+// 借阅校验所需的用户身份, 不含 email / password_hash
+struct UserIdentity {
+    int id{0};
+    std::string username;
+    std::string role;
+    bool active{false};     // users 表没有停用标记, 行存在即为 active
+};
+
+struct UserDirectoryStats {
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};    // 需要查询数据库 (包括不存在的用户)
+    std::size_t entries{0};
+    std::size_t slot_bytes{0};  // 条目表大小
+    std::size_t name_bytes{0};  // 用户名存储区大小, 含待回收部分
+};
+
+/*
+进程内用户目录: id -> (username, role), 首次访问时从数据库加载.
+
+条目放在开放寻址 (线性探测) 的平铺数组里, 每槽 12 字节 (id + 8 字节条目),
+装载率超过 3/4 时翻倍, 所以每个用户占 16 到 32 字节; 没有逐条分配的节点. 用户名放在共享的
+字符存储区里, 条目只记偏移和长度; role 取值很少, 按下标引用去重后的角色表.
+几十万用户也只需几 MB.
+
+User::update / remove 和 users 表的 NOTIFY (InvalidationListener) 使条目失效,
+监听连接重连时清空整个目录. 不存在的 id 不缓存, 每次都会查询数据库.
+*/
+class UserDirectory {
+public:
+    static UserDirectory& getInstance(){
+        static UserDirectory instance;
+        return instance;
+    }
+
+    UserDirectory(const UserDirectory&) = delete;
+    UserDirectory& operator=(const UserDirectory&) = delete;
+    ~UserDirectory();
+
+    // nullopt if the user does not exist or the lookup failed
+    std::optional<UserIdentity> find(int user_id);
+    bool exists(int user_id) { return find(user_id).has_value(); }
+
+    void invalidate(int user_id);
+    void clear();
+
+    [[nodiscard]] UserDirectoryStats stats() const;
+
+private:
+    UserDirectory();
+
+    struct Entry {
+        std::uint32_t name_offset{0};
+        std::uint16_t name_length{0};
+        std::uint8_t role{0};           // index into roles_
+        std::uint8_t flags{0};
+    };
+
+    struct Slot {
+        int user_id{0};                 // 0 表示空槽, 有效 id 都大于 0
+        Entry entry;
+    };
+
+    static constexpr std::uint8_t FLAG_ACTIVE = 1;
+
+    std::optional<UserIdentity> lookup(int user_id) const;
+    std::optional<UserIdentity> load(int user_id);
+    void insert(int user_id, const std::string& username, const std::string& role, std::uint64_t seen_generation);
+    std::uint8_t roleIndex(const std::string& role);
+    void eraseLocked(int user_id);
+    void compactLocked();
+
+    // 开放寻址表, 调用方持有 mutex_
+    std::size_t home(int user_id) const;
+    const Slot* findSlot(int user_id) const;
+    void insertSlot(int user_id, const Entry& entry);
+    void eraseSlot(std::size_t index);
+    void rehash(std::size_t capacity);
+
+    mutable std::shared_mutex mutex_;
+    std::vector<Slot> slots_;           // 容量为 2 的幂
+    std::size_t size_{0};
+    std::string names_;                 // 所有用户名首尾相接
+    std::size_t garbage_bytes_{0};      // 已失效条目留下的用户名字节
+    std::vector<std::string> roles_;
+
+    std::atomic<std::uint64_t> generation_{0};
+    mutable std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::vector<int> subscriptions_;    // InvalidationListener
+};
@@ -1,14 +1,49 @@
 // include/services/book_service.hpp
 
+#pragma once
 #include <memory.h>
+#include <istream>
+#include <ostream>
 #include <memory>
 #include <string>
 #include <vector>
 #include <cstring>
 #include "models/user.hpp"
 #include "models/book.hpp"
+#include "models/borrowing_record.hpp"
 
 #define PAGESIZE 10
+#define MAX_PAGESIZE 100
+
+#define IMPORT_CHUNK_LINES 8192   // 每批并行解析的行数, 一批解析时上一批写入 COPY
+#define IMPORT_PARSE_BLOCK 256    // 解析线程每次领取的行数
+#define MAX_IMPORT_ERRORS 1000    // 报告中最多保留的错误条数
+
+enum class ImportFormat {
+    CSV,    // isbn,title,author,publisher,publish_date,category,total_copies; 可带表头, 按表头列名映射
+    NDJSON  // 每行一个 JSON 对象, 字段名同 handleAddBook
+};
+
+struct ImportError {
+    long line{0};           // 输入中的行号, 0 表示整个导入失败
+    std::string message;
+};
+
+struct ImportReport {
+    long rows_read{0};
+    long inserted{0};
+    long updated{0};
+    long rejected{0};       // 校验失败或 ISBN 重复的行
+    bool committed{false};
+    std::vector<ImportError> errors;
+};
+
+// 一页图书, next_cursor 为空表示已经是最后一页
+struct BookPage {
+    BookList books;
+    std::string next_cursor;
+};
+
 class BookService {
 public:
     BookService(const BookService&) = delete;
@@ -40,19 +75,37 @@ public:
         int total_copies
     );
 
+    /*
+    Stream a catalog feed into books. Lines are parsed and validated in parallel
+    (each chunk while the previous one streams into COPY), duplicate ISBNs keep
+    their first occurrence, and accepted rows are COPYed and merged in one
+    transaction (existing ISBNs are updated). Rejected rows are reported per
+    line and do not stop the import.
+    */
+    [[nodiscard]] ImportReport importBooks(std::istream& input, ImportFormat format);
+
+    // Nightly catalog extract, streamed with flat memory; returns rows written, -1 on error
+    [[nodiscard]] long exportBooks(std::ostream& out, ExportFormat format,
+        ExportCompression compression = ExportCompression::NONE);
+
     // Search in books
     [[nodiscard]] bool removeBook(int book_id);
     [[nodiscard]] std::unique_ptr<Book> getBookById(int book_id);
     [[nodiscard]] std::unique_ptr<Book> getBookByIsdn(const std::string &isdn);
-    [[nodiscard]] std::vector<std::unique_ptr<Book>> SearchBooks(const std::string& keyword);
-    [[nodiscard]] std::vector<std::unique_ptr<Book>> getAllBooks(int page = 1, int pagesize = PAGESIZE);
+    [[nodiscard]] BookList SearchBooks(const std::string& keyword);
+    // cursor is the token from a previous page's next_cursor, empty for the first page;
+    // throws std::invalid_argument for a token we did not issue
+    [[nodiscard]] BookPage getAllBooks(const std::string& cursor = "", int pagesize = PAGESIZE);
     [[nodiscard]] int getTotalBooks();
+    // 总数、总复本数、可借复本数及各分类计数, 一次读取计数表
+    [[nodiscard]] CatalogCounters getCatalogCounters();
 
 
     //Borrow Return
     [[nodiscard]] bool borrowBook(int user_id, int book_id);
     [[nodiscard]] bool returnBook(int user_id, int book_id);
-    [[nodiscard]] std::vector<std::unique_ptr<Book>> getBorrowedBooks(int user_id);
+    // 用户当前借阅的图书 (借阅记录 + 图书信息), 一次 JOIN 查询
+    [[nodiscard]] LoanList getBorrowedBooks(int user_id);
 
 private:
     BookService() = default;
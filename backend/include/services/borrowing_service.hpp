@@ -1,7 +1,12 @@
 // include/services/borrowing_service.hpp
+
+#pragma once
 #include <memory.h>
 #include <memory>
+#include <optional>
+#include <ostream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "models/borrowing_record.hpp"
 #include "models/book.hpp"
@@ -9,6 +14,7 @@
 
 #define MAX_BORROW_TIME 14
 #define MAX_BORROW_LIMIT 5
+#define MAX_STATUS_BATCH 500     // 批量查询借阅状态时每次最多的用户数
 class BorrowingService{
 public:
     static BorrowingService& getInstance(){
@@ -19,10 +25,12 @@ public:
     BorrowingService(const BorrowingService&) = delete;
     BorrowingService& operator=(const BorrowingService&) = delete;
 
-    [[nodiscard]] std::unique_ptr<BorrowingRecord> borrowBook(int user_id, int book_id,
-     const std::string& borrow_date = "", const std::string& return_date = "");
+    // 未指定的日期取当前时间, 应还日期默认为借阅日期 + MAX_BORROW_TIME 天;
+    // 被拒绝时 record 为空, refusal 说明原因
+    [[nodiscard]] BorrowingRecord::BorrowResult borrowBook(int user_id, int book_id,
+     std::optional<Timestamp> borrow_date = std::nullopt, std::optional<Timestamp> due_date = std::nullopt);
     [[nodiscard]] bool returnBook(int user_id, int book_id,
-    const std::string& return_date = "");
+    std::optional<Timestamp> return_date = std::nullopt);
 
     [[nodiscard]] bool renewBook(int user_id, int book_id);
 
@@ -32,16 +40,24 @@ public:
     [[nodiscard]]std::vector<std::unique_ptr<BorrowingRecord>>
     getBookBorrowings(int book_id, bool include_returned = false);
 
-    [[nodiscard]] std::vector<std::unique_ptr<BorrowingRecord>>
-    getOverdueBooks();
+    [[nodiscard]] BorrowingList getOverdueBooks();
+
+    // 借阅历史导出, borrow_date 在 [from, to) 内, 空串表示不限; 返回行数, 出错返回-1
+    [[nodiscard]] long exportHistory(std::ostream& out, ExportFormat format,
+        ExportCompression compression = ExportCompression::NONE,
+        const std::string& from = "", const std::string& to = "");
 
     [[nodiscard]] int getUserCurrentBorrowCount(int user_id) const;
     [[nodiscard]] int getUserOverdueCount(int user_id) const;
 
+    // 多个用户的借阅数和逾期数, 一次查询; 出错返回空表
+    [[nodiscard]] std::unordered_map<int, BorrowingRecord::BorrowStatus>
+    getUserBorrowStatuses(const std::vector<int>& user_ids) const;
+
 private:
     BorrowingService() = default;
-    [[nodiscard]] std::string getCurrentDate() const;
-    [[nodiscard]] std::string calculateDueDate(const std::string& borrow_date) const;
+    [[nodiscard]] static Timestamp getCurrentTime();
+    [[nodiscard]] static Timestamp calculateDueDate(Timestamp borrow_date);
     [[nodiscard]] bool validateBorrowLimit(int user_id) const;
     [[nodiscard]] bool validateOverdue(int user_id) const;
 };
@@ -0,0 +1,180 @@
+// include/utils/async_query.hpp
+
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <libpq-fe.h>
+
+/*
+Result of an asynchronous query, owns the libpq result.
+Values are text-format views valid for the lifetime of the AsyncResult.
+*/
+class AsyncResult {
+public:
+    AsyncResult() = default;
+    explicit AsyncResult(PGresult* result) : result_(result, &PQclear) {}
+
+    [[nodiscard]] bool empty() const { return rows() == 0; }
+    [[nodiscard]] int rows() const { return result_ ? PQntuples(result_.get()) : 0; }
+    [[nodiscard]] int columns() const { return result_ ? PQnfields(result_.get()) : 0; }
+
+    // Column index by name, -1 if the result has no such column
+    [[nodiscard]] int column(const char* name) const {
+        return result_ ? PQfnumber(result_.get(), name) : -1;
+    }
+
+    [[nodiscard]] bool isNull(int row, int col) const {
+        return PQgetisnull(result_.get(), row, col) != 0;
+    }
+
+    [[nodiscard]] std::string_view get(int row, int col) const {
+        return {PQgetvalue(result_.get(), row, col),
+                static_cast<std::size_t>(PQgetlength(result_.get(), row, col))};
+    }
+
+    [[nodiscard]] std::string_view get(int row, const char* name) const {
+        return get(row, column(name));
+    }
+
+    [[nodiscard]] int getInt(int row, const char* name) const;
+
+private:
+    std::shared_ptr<PGresult> result_;
+};
+
+/*
+Runs prepared statements from utils/statements.hpp without blocking the caller.
+
+The executor owns DB_ASYNC_CONNECTIONS libpq connections in non-blocking
+mode and one event loop thread that poll()s all of their sockets. Each
+connection carries one query at a time; further queries wait in a FIFO
+queue and are sent as soon as a connection frees up. One caller thread
+can therefore keep as many queries in flight as there are connections.
+
+Connections are opened and prepared by the event loop itself
+(PQconnectStart/PQconnectPoll, then one PQsendPrepare per statement), so a
+slow or unreachable database never stalls queries on the other connections.
+An attempt that takes longer than DB_ASYNC_CONNECT_TIMEOUT_SEC is abandoned;
+a failed connection is retried on demand after DB_ASYNC_RETRY_MS. Queued
+queries fail at once when no connection is open or being opened.
+
+Completion callbacks run on the event loop thread and must not block.
+*/
+class AsyncExecutor {
+public:
+    using Callback = std::function<void(AsyncResult result, std::exception_ptr error)>;
+
+    static AsyncExecutor& getInstance() {
+        static AsyncExecutor instance;
+        return instance;
+    }
+
+    AsyncExecutor(const AsyncExecutor&) = delete;
+    AsyncExecutor& operator=(const AsyncExecutor&) = delete;
+    ~AsyncExecutor();
+
+    /*
+    Queue a prepared statement, params are sent in text format.
+    on_done receives the result, or an exception_ptr if the query failed.
+    */
+    void submit(const char* statement, std::vector<std::string> params, Callback on_done);
+
+    /*
+    Queue a prepared statement and return a future for its result
+    */
+    std::future<AsyncResult> execPrepared(const char* statement, std::vector<std::string> params);
+
+    /*
+    Queue a prepared statement and return a future for convert(result).
+    convert runs on the event loop thread, its exceptions are forwarded to the future.
+    */
+    template <typename T, typename Convert>
+    std::future<T> execPrepared(const char* statement, std::vector<std::string> params, Convert convert) {
+        auto promise = std::make_shared<std::promise<T>>();
+        auto future = promise->get_future();
+
+        submit(statement, std::move(params), [promise, convert](AsyncResult result, std::exception_ptr error) {
+            if (error) {
+                promise->set_exception(error);
+                return;
+            }
+            try {
+                promise->set_value(convert(result));
+            } catch (...) {
+                promise->set_exception(std::current_exception());
+            }
+        });
+        return future;
+    }
+
+private:
+    struct Request {
+        const char* statement{nullptr};
+        std::vector<std::string> params;
+        Callback on_done;
+    };
+
+    enum class State {
+        Closed,         // no connection, reopened on demand once retry_at has passed
+        Connecting,     // PQconnectPoll in progress
+        Preparing,      // sending the statement catalog, one statement at a time
+        Ready
+    };
+
+    struct Connection {
+        PGconn* conn{nullptr};
+        State state{State::Closed};
+        PostgresPollingStatusType polling{PGRES_POLLING_WRITING};
+        std::size_t prepared{0};    // statements_ already prepared
+        std::chrono::steady_clock::time_point deadline;     // connect timeout while opening
+        std::chrono::steady_clock::time_point retry_at;     // earliest reconnect while Closed
+        bool busy{false};
+        bool flushing{false};       // query not fully written to the socket yet
+        AsyncResult last_result;
+        std::exception_ptr error;
+        Callback on_done;
+    };
+
+    AsyncExecutor();
+
+    void eventLoop();
+    void dispatch();
+    bool send(Connection& connection, Request& request);
+    void onReadable(Connection& connection);
+    void finish(Connection& connection);
+    void startConnect(Connection& connection);
+    void continueConnect(Connection& connection);
+    bool sendPrepare(Connection& connection);
+    void onPrepared(Connection& connection);
+    void failConnect(Connection& connection, const std::string& message);
+    void drop(Connection& connection);
+    int pollTimeout() const;
+    void wake();
+
+    std::string conn_str_;
+    std::vector<std::pair<const char*, const char*>> statements_;  // (name, sql) from the catalog
+    std::chrono::seconds connect_timeout_;
+    std::chrono::milliseconds retry_delay_;
+
+    // only touched by the event loop thread
+    std::vector<Connection> connections_;
+    std::string last_error_;                // why the most recent connect attempt failed
+
+    std::mutex mutex_;
+    std::deque<Request> queue_;
+    bool stopping_{false};
+
+    int wake_fds_[2]{-1, -1};
+    std::thread loop_thread_;
+};
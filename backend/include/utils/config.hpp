@@ -1,6 +1,7 @@
 // include/utils/config.hpp
 
 #pragma once
+#include <exception>
 #include <string>
 #include <unordered_map>
 
@@ -16,6 +17,21 @@ public:
         return iter != config_.end() ? iter->second : "" ;
     }
 
+    /*
+    Numeric setting, falls back to default_value when missing or malformed
+    */
+    int getInt(const std::string& key, int default_value) const {
+        auto iter = config_.find(key);
+        if (iter == config_.end()) {
+            return default_value;
+        }
+        try {
+            return std::stoi(iter->second);
+        } catch (const std::exception&) {
+            return default_value;
+        }
+    }
+
 private:
     Config() {
         loadConfig();
@@ -27,6 +43,27 @@ private:
         config_["DB_PASSWORD"] = "password";
         config_["DB_HOST"] = "localhost";
         config_["DB_PORT"] = "5432";
+
+        // Connection pool sizing
+        config_["DB_POOL_MIN"] = "2";                   // opened in the background at startup
+        config_["DB_POOL_MAX"] = "10";                  // hard cap, the pool grows on demand up to this
+        config_["DB_POOL_IDLE_TIMEOUT_SEC"] = "300";    // idle connections above DB_POOL_MIN are closed after this
+        config_["DB_POOL_PING_AFTER_SEC"] = "30";       // connections idle this long are pinged before reuse, 0 disables
+
+        // Read replica for catalog and history reads, leave DB_REPLICA_HOST empty to read from the primary
+        config_["DB_REPLICA_HOST"] = "";
+        config_["DB_REPLICA_PORT"] = "";                // defaults to DB_PORT
+        config_["DB_READ_YOUR_WRITES_MS"] = "1000";     // a patron's reads stay on the primary this long after their write, 0 disables
+
+        // Non-blocking query executor (AsyncExecutor), one query in flight per connection
+        config_["DB_ASYNC_CONNECTIONS"] = "4";
+        config_["DB_ASYNC_CONNECT_TIMEOUT_SEC"] = "5";  // give up on a connection attempt after this
+        config_["DB_ASYNC_RETRY_MS"] = "1000";          // wait this long before retrying a failed connection
+
+        // Cache invalidation over LISTEN/NOTIFY (InvalidationListener), channel must match database/init.sql
+        config_["DB_NOTIFY_CHANNEL"] = "cache_invalidation";
+        config_["DB_NOTIFY_BATCH_MS"] = "50";           // notifications within this window are applied as one batch
+        config_["DB_NOTIFY_RETRY_SEC"] = "5";           // reconnect interval of the listener connection
     }
 std::unordered_map<std::string , std::string> config_;
 
@@ -0,0 +1,120 @@
+// include/utils/cursor_scan.hpp
+
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <pqxx/pqxx>
+#include "utils/database_pool.hpp"
+#include "utils/result_set.hpp"
+
+#define STREAM_BATCH_SIZE 500
+
+/*
+Walks a query through a server-side cursor, FETCHing batch_size rows at a time.
+
+Only the current batch is held in memory, so nightly jobs can visit whole
+tables with bounded memory. Either pull batches with nextBatch()/batch(), or
+iterate rows in a range-for:
+
+    for (const auto& record : BorrowingRecord::scan(filter)) { ... }
+
+Rows (and their string views) are valid until the scan moves to the next
+batch. The scan holds a read connection and a read-only transaction open
+until it is destroyed. Errors are logged and end the scan early; check failed().
+*/
+template <typename Row>
+class CursorScan {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Row;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Row*;
+        using reference = const Row&;
+
+        iterator() = default;
+        explicit iterator(CursorScan* scan) : scan_(scan) {}
+
+        reference operator*() const { return scan_->batch()[index_]; }
+        pointer operator->() const { return &scan_->batch()[index_]; }
+
+        iterator& operator++() {
+            if (++index_ >= scan_->batch().size()) {
+                index_ = 0;
+                if (!scan_->nextBatch()) {
+                    scan_ = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const { return scan_ == other.scan_ && index_ == other.index_; }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+
+    private:
+        CursorScan* scan_{nullptr};
+        std::size_t index_{0};
+    };
+
+    CursorScan(const std::string& query, const PoolSite& site, int batch_size = STREAM_BATCH_SIZE) {
+        try {
+            state_ = std::make_unique<State>(DatabasePool::getInstance().getReadConnection(site), query, batch_size);
+        } catch (const std::exception& e) {
+            std::cerr << "Error in CursorScan(" << site << "): " << e.what() << std::endl;
+            failed_ = true;
+        }
+    }
+
+    /*
+    Fetch the next batch, false once the cursor is exhausted or failed
+    */
+    bool nextBatch() {
+        if (state_ == nullptr) {
+            return false;
+        }
+
+        try {
+            state_->batch.clear();
+            pqxx::result rows;
+            if (!(state_->stream >> rows) || rows.empty()) {
+                state_.reset();     // close the cursor and hand the connection back early
+                return false;
+            }
+            state_->batch.append(rows);
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << "Error in CursorScan::nextBatch(): " << e.what() << std::endl;
+            failed_ = true;
+            state_.reset();
+            return false;
+        }
+    }
+
+    [[nodiscard]] const ResultSet<Row>& batch() const { return state_->batch; }
+    [[nodiscard]] bool failed() const { return failed_; }
+
+    iterator begin() { return nextBatch() ? iterator(this) : iterator(); }
+    iterator end() { return {}; }
+
+private:
+    struct State {
+        State(PooledConnection connection, const std::string& query, int batch_size)
+            : conn(std::move(connection)),
+              txn(*conn),
+              stream(txn, query, "scan", batch_size) {}
+
+        PooledConnection conn;
+        pqxx::read_transaction txn;
+        pqxx::icursorstream stream;
+        ResultSet<Row> batch;
+    };
+
+    // heap-held so the transaction and cursor never move while a scan is returned by value
+    std::unique_ptr<State> state_;
+    bool failed_{false};
+};
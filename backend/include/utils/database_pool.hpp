@@ -1,15 +1,519 @@
 // include/utils/database_pool.hpp
 
 #pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
 #include <memory.h>
 #include <memory>
-#include <queue>
 #include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
 #include <pqxx/pqxx>
 #include "utils/config.hpp"
+#include "utils/pool_metrics.hpp"
+#include "utils/statements.hpp"
 
-#define MAX_CONNECTIONS 10
+#define DB_NO_SESSION 0             // session id of requests without a patron, never pinned
+#define DB_SESSION_PIN_SLOTS 4096   // read-your-writes pins, sessions hashing to the same slot share a pin
+
+class ConnectionSet;
+
+/*
+One pooled connection.
+in_use is the only field touched without holding the slot, so leasing
+an idle slot is a single atomic exchange. Each slot sits on its own
+cache line so threads leasing different slots don't contend.
+*/
+struct alignas(64) PoolSlot {
+    std::atomic<bool> in_use{false};
+    std::atomic<bool> open{false};          // hint for the scan, the owner keeps it in sync with conn
+    std::atomic<std::int64_t> last_used{0}; // steady_clock ticks of the last return, read by the idle reaper
+    std::shared_ptr<pqxx::connection> conn; // only accessed by the thread holding the slot
+    SlotMetrics metrics;                    // recorded by the thread holding the slot
+};
+
+/*
+Scoped lease on a pooled connection.
+The connection goes back to the pool when the lease is destroyed,
+so callers never have to call releaseConnection() themselves.
+*/
+class PooledConnection {
+public:
+    PooledConnection() = default;
+    PooledConnection(const PooledConnection&) = delete;
+    PooledConnection& operator=(const PooledConnection&) = delete;
+
+    PooledConnection(PooledConnection&& other) noexcept
+        : pool_(std::exchange(other.pool_, nullptr)),
+          slot_(std::exchange(other.slot_, nullptr)),
+          site_(other.site_),
+          acquired_(other.acquired_) {}
+
+    PooledConnection& operator=(PooledConnection&& other) noexcept {
+        if (this != &other) {
+            release();
+            pool_ = std::exchange(other.pool_, nullptr);
+            slot_ = std::exchange(other.slot_, nullptr);
+            site_ = other.site_;
+            acquired_ = other.acquired_;
+        }
+        return *this;
+    }
+
+    ~PooledConnection() {
+        release();
+    }
+
+    pqxx::connection& operator*() const { return *slot_->conn; }
+    pqxx::connection* operator->() const { return slot_->conn.get(); }
+    pqxx::connection* get() const { return slot_ != nullptr ? slot_->conn.get() : nullptr; }
+    explicit operator bool() const { return slot_ != nullptr; }
+
+    /*
+    Hand the connection back early, before the lease goes out of scope
+    */
+    void release();
+
+private:
+    friend class ConnectionSet;
+
+    PooledConnection(ConnectionSet* pool,
+                     PoolSlot* slot,
+                     std::size_t site,
+                     std::chrono::steady_clock::time_point acquired)
+        : pool_(pool), slot_(slot), site_(site), acquired_(acquired) {}
+
+    ConnectionSet* pool_{nullptr};
+    PoolSlot* slot_{nullptr};
+    std::size_t site_{0};                // PoolSite index, hold time is also recorded per call site
+    std::chrono::steady_clock::time_point acquired_;
+};
+
+/*
+Set of pooled connections to one server, built on a fixed array of
+DB_POOL_MAX slots. DatabasePool keeps one set for the primary and,
+when configured, one for a read replica.
+
+Slots start empty and are connected on first lease, so the set grows
+on demand. A maintenance thread opens DB_POOL_MIN connections in the
+background at startup and closes connections idle for longer than
+DB_POOL_IDLE_TIMEOUT_SEC, never shrinking below DB_POOL_MIN.
+
+Before an idle connection is reused its socket is probed without
+blocking; a connection idle for longer than DB_POOL_PING_AFTER_SEC is
+also pinged with a round trip. Connections that fail either check are
+reopened, so a server restart or a dropped TCP session costs one
+reconnect instead of a failed query.
+
+Fast path: a thread first retries the slot it used last, then scans the
+array from a per-thread offset, claiming the first free slot with one
+atomic exchange. No lock is taken unless every slot is busy.
+
+Slow path: callers that find no free slot queue up behind wait_mutex_
+and are served strictly in arrival order. Returning a slot while
+someone is queued hands it straight to the oldest waiter.
+*/
+class ConnectionSet {
+public:
+    ConnectionSet(std::string name,
+                  std::string conn_str,
+                  int min_connections,
+                  int max_connections,
+                  std::chrono::steady_clock::duration idle_timeout,
+                  std::chrono::steady_clock::duration ping_after)
+        : name_(std::move(name)),
+          conn_str_(std::move(conn_str)),
+          max_connections_(std::max(1, max_connections)),
+          min_connections_(std::clamp(min_connections, 0, max_connections_)),
+          idle_timeout_(idle_timeout),
+          ping_after_(ping_after),
+          slots_(new PoolSlot[max_connections_]) {
+        maintenance_thread_ = std::thread([this] { maintenanceLoop(); });
+    }
+
+    ConnectionSet(const ConnectionSet&) = delete;
+    ConnectionSet& operator=(const ConnectionSet&) = delete;
+
+    ~ConnectionSet() {
+        {
+            std::lock_guard<std::mutex> lock(maintenance_mutex_);
+            stopping_ = true;
+        }
+        maintenance_cv_.notify_one();
+        if (maintenance_thread_.joinable()) {
+            maintenance_thread_.join();
+        }
+    }
+
+    /*
+    Lease a connection from the set.
+    site names the caller (e.g. "Book::search") for the per-site hold time histogram.
+    Broken connections are reopened before they are handed out,
+    throws if the database cannot be reached.
+    */
+    PooledConnection lease(const PoolSite& site) {
+        const auto started = std::chrono::steady_clock::now();
+        PoolSlot* slot = acquireSlot();
+
+        try {
+            const bool was_open = slot->open.load(std::memory_order_relaxed);
+            if (!was_open || !isAlive(*slot)) {
+                if (was_open) {
+                    metrics_.reconnects.fetch_add(1, std::memory_order_relaxed);
+                }
+                openSlot(*slot);
+            }
+        } catch (...) {
+            // Free the slot so a waiter can try to connect again
+            releaseSlot(slot);
+            throw;
+        }
+
+        const auto acquired = std::chrono::steady_clock::now();
+        slot->metrics.acquires.fetch_add(1, std::memory_order_relaxed);
+        slot->metrics.acquire_wait.record(acquired - started);
+
+        return {this, slot, site.index(), acquired};
+    }
+
+    /*
+    Snapshot of gauges, counters and latency histograms
+    */
+    PoolStats stats() const {
+        PoolStats stats;
+        stats.max_connections = max_connections_;
+        stats.open_connections = open_connections_.load(std::memory_order_relaxed);
+        stats.waiters = waiting_.load(std::memory_order_relaxed);
+
+        for (int i = 0; i < max_connections_; i++) {
+            const PoolSlot& slot = slots_[i];
+            if (slot.in_use.load(std::memory_order_relaxed)) {
+                stats.in_use++;
+            }
+            else if (slot.open.load(std::memory_order_relaxed)) {
+                stats.idle++;
+            }
+            slot.metrics.fill(stats);
+        }
+
+        metrics_.fill(stats);
+        return stats;
+    }
+
+private:
+    friend class PooledConnection;
+
+    struct Waiter {
+        std::condition_variable cv;
+        PoolSlot* slot{nullptr};
+    };
+
+    // Last slot used by this thread in each set (primary and replica)
+    struct LastSlot {
+        const ConnectionSet* set{nullptr};
+        PoolSlot* slot{nullptr};
+    };
+
+    const std::string name_;
+    const std::string conn_str_;
+    const int max_connections_;
+    const int min_connections_;
+    const std::chrono::steady_clock::duration idle_timeout_;
+    const std::chrono::steady_clock::duration ping_after_;
+    std::unique_ptr<PoolSlot[]> slots_;
+    std::atomic<int> open_connections_{0};
+    PoolMetrics metrics_;
+
+    std::atomic<int> waiting_{0};
+    std::mutex wait_mutex_;
+    std::deque<Waiter*> waiters_;
+
+    std::mutex maintenance_mutex_;
+    std::condition_variable maintenance_cv_;
+    bool stopping_{false};
+    std::thread maintenance_thread_;
+
+
+    static std::int64_t now() {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    LastSlot& lastSlot() const {
+        thread_local LastSlot last[2];
+        if (last[0].set == this || last[0].set == nullptr) {
+            return last[0];
+        }
+        return last[1].set == this || last[1].set == nullptr ? last[1] : last[0];
+    }
+
+    static std::size_t threadOffset() {
+        thread_local const std::size_t offset = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return offset;
+    }
+
+    PoolSlot* acquireSlot() {
+        // Don't overtake queued callers, they are served first
+        if (waiting_.load(std::memory_order_seq_cst) == 0) {
+            LastSlot& last = lastSlot();
+            if (last.set == this && !last.slot->in_use.exchange(true, std::memory_order_acquire)) {
+                return last.slot;
+            }
+
+            if (PoolSlot* slot = tryAcquireAny()) {
+                return slot;
+            }
+        }
+
+        return waitForSlot();
+    }
+
+    /*
+    Claim any free slot, preferring ones that already hold an open connection
+    */
+    PoolSlot* tryAcquireAny() {
+        const std::size_t count = static_cast<std::size_t>(max_connections_);
+        const std::size_t start = threadOffset() % count;
+
+        for (bool want_open : {true, false}) {
+            for (std::size_t i = 0; i < count; i++) {
+                PoolSlot& slot = slots_[(start + i) % count];
+                if (slot.open.load(std::memory_order_relaxed) != want_open ||
+                    slot.in_use.load(std::memory_order_seq_cst)) {
+                    continue;
+                }
+                if (!slot.in_use.exchange(true, std::memory_order_acquire)) {
+                    return &slot;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    PoolSlot* waitForSlot() {
+        Waiter waiter;
+        std::unique_lock<std::mutex> lock(wait_mutex_);
+
+        // Must be visible before the scan below, pairs with the load in releaseSlot()
+        waiting_.fetch_add(1, std::memory_order_seq_cst);
+
+        if (waiters_.empty()) {
+            if (PoolSlot* slot = tryAcquireAny()) {
+                waiting_.fetch_sub(1, std::memory_order_relaxed);
+                return slot;
+            }
+        }
+
+        waiters_.push_back(&waiter);
+        waiter.cv.wait(lock, [&waiter] { return waiter.slot != nullptr; });
+        waiting_.fetch_sub(1, std::memory_order_relaxed);
+        return waiter.slot;
+    }
+
+    /*
+    Return a slot to the pool, only called by PooledConnection.
+    Connections that went bad while leased are dropped instead of recycled.
+    */
+    void releaseSlot(PoolSlot* slot) {
+        if (slot->conn == nullptr || !slot->conn->is_open()) {
+            closeSlot(*slot);
+        }
+
+        lastSlot() = {this, slot};
+        slot->last_used.store(now(), std::memory_order_relaxed);
+        returnSlot(slot);
+    }
+
+    void returnSlot(PoolSlot* slot) {
+        slot->in_use.store(false, std::memory_order_seq_cst);
+
+        if (waiting_.load(std::memory_order_seq_cst) > 0) {
+            handOffToWaiters();
+        }
+    }
+
+    void handOffToWaiters() {
+        std::lock_guard<std::mutex> lock(wait_mutex_);
+        while (!waiters_.empty()) {
+            PoolSlot* slot = tryAcquireAny();
+            if (slot == nullptr) {
+                return;
+            }
+
+            Waiter* waiter = waiters_.front();
+            waiters_.pop_front();
+            waiter->slot = slot;
+            waiter->cv.notify_one();
+        }
+    }
+
+    /*
+    Liveness check of an open connection before it is handed out.
+    An idle pooled connection never has unread data, so a readable socket
+    means the server closed it or sent a termination notice. The extra
+    round trip is only paid after ping_after_ of idleness.
+    */
+    bool isAlive(PoolSlot& slot) const {
+        if (slot.conn == nullptr || !slot.conn->is_open()) {
+            return false;
+        }
+
+        pollfd fd{};
+        fd.fd = slot.conn->sock();
+        fd.events = POLLIN;
+        if (fd.fd < 0 || ::poll(&fd, 1, 0) < 0) {
+            return false;
+        }
+        if ((fd.revents & (POLLERR | POLLHUP | POLLNVAL)) != 0) {
+            return false;
+        }
+        if ((fd.revents & POLLIN) != 0) {
+            char byte;
+            const ssize_t n = ::recv(fd.fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+            if (n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                return false;
+            }
+        }
+
+        if (ping_after_.count() > 0 &&
+            now() - slot.last_used.load(std::memory_order_relaxed) >= ping_after_.count()) {
+            try {
+                pqxx::nontransaction ping(*slot.conn);
+                ping.exec("SELECT 1");
+            } catch (const std::exception& e) {
+                std::cerr << "Error in ConnectionSet::isAlive() [" << name_ << "]: " << e.what() << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void openSlot(PoolSlot& slot) {
+        closeSlot(slot);
+        try {
+            slot.conn = CreateConnection();
+        } catch (...) {
+            metrics_.creation_failures.fetch_add(1, std::memory_order_relaxed);
+            throw;
+        }
+        metrics_.connections_created.fetch_add(1, std::memory_order_relaxed);
+        slot.open.store(true, std::memory_order_relaxed);
+        open_connections_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void closeSlot(PoolSlot& slot) {
+        if (slot.open.exchange(false, std::memory_order_relaxed)) {
+            open_connections_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        slot.conn.reset();
+    }
+
+    /*
+    Background warm-up, then periodic idle eviction until the pool is destroyed
+    */
+    void maintenanceLoop() {
+        warmUp();
+
+        const auto interval = std::max<std::chrono::steady_clock::duration>(
+            std::chrono::seconds(1), idle_timeout_ / 4);
+
+        std::unique_lock<std::mutex> lock(maintenance_mutex_);
+        while (!maintenance_cv_.wait_for(lock, interval, [this] { return stopping_; })) {
+            lock.unlock();
+            evictIdle();
+            lock.lock();
+        }
+    }
+
+    void warmUp() {
+        for (int i = 0; i < max_connections_; i++) {
+            if (open_connections_.load(std::memory_order_relaxed) >= min_connections_) {
+                return;
+            }
+
+            PoolSlot& slot = slots_[i];
+            if (slot.open.load(std::memory_order_relaxed) ||
+                slot.in_use.exchange(true, std::memory_order_acquire)) {
+                continue;
+            }
+
+            bool ok = true;
+            try {
+                if (!slot.open.load(std::memory_order_relaxed)) {
+                    openSlot(slot);
+                    slot.last_used.store(now(), std::memory_order_relaxed);
+                }
+            } catch (const std::exception& e) {
+                // Leave the rest to getConnection(), which retries on demand
+                std::cerr << "Error in ConnectionSet::warmUp() [" << name_ << "]: " << e.what() << std::endl;
+                ok = false;
+            }
+            returnSlot(&slot);
+            if (!ok) {
+                return;
+            }
+        }
+    }
+
+    void evictIdle() {
+        const std::int64_t deadline = now() - idle_timeout_.count();
+
+        for (int i = 0; i < max_connections_; i++) {
+            if (open_connections_.load(std::memory_order_relaxed) <= min_connections_) {
+                return;
+            }
+
+            PoolSlot& slot = slots_[i];
+            if (!slot.open.load(std::memory_order_relaxed) ||
+                slot.last_used.load(std::memory_order_relaxed) > deadline ||
+                slot.in_use.exchange(true, std::memory_order_acquire)) {
+                continue;
+            }
+
+            // Re-check under ownership, the slot may have been used since the first look
+            if (slot.last_used.load(std::memory_order_relaxed) <= deadline) {
+                closeSlot(slot);
+                metrics_.idle_evictions.fetch_add(1, std::memory_order_relaxed);
+            }
+            returnSlot(&slot);
+        }
+    }
+
+    std::shared_ptr<pqxx::connection> CreateConnection() const {
+        auto conn = std::make_shared<pqxx::connection>(conn_str_);
+        prepareStatements(*conn);
+        return conn;
+    }
+};
+
+/*
+Process-wide entry point to the database.
+
+  getConnection()       primary, for reads that must see the latest data
+  getWriteConnection()  primary, for writes
+  getReadConnection()   read replica when DB_REPLICA_HOST is set, else primary;
+                        for catalog and history reads that tolerate replica lag
+
+Read-your-writes is tracked per session, not per thread: requests are
+served by whichever thread is free, so a thread-local pin would follow
+the thread onto another patron's request. A write made for a session
+(the patron's user id; there is no separate HTTP session layer) keeps
+that session's reads on the primary for DB_READ_YOUR_WRITES_MS.
+Pins live in a fixed table of DB_SESSION_PIN_SLOTS deadlines indexed by
+session hash; a collision only sends another session's reads to the
+primary for a while, never to stale data.
+*/
 class DatabasePool {
 public:
     static DatabasePool& getInstance() {
@@ -17,58 +521,148 @@ public:
         return instance;
     }
 
+    DatabasePool(const DatabasePool&) = delete;
+    DatabasePool& operator=(const DatabasePool&) = delete;
+
     /*
-    Get the connetion ptr for the database
+    While alive, getReadConnection() on this thread goes to the primary.
+    For results that outlive the request, e.g. response bodies cached under
+    the catalog version, which only moves after a primary commit: built from
+    a lagging replica they would stay stale until the next unrelated write.
+    Only covers the enclosing call, so it can't leak onto another request.
     */
-    std::shared_ptr<pqxx::connection> getConnection() {
-        std::unique_lock<std::mutex> lock(mutex_);
+    class PrimaryReadScope {
+    public:
+        PrimaryReadScope() { depth()++; }
+        ~PrimaryReadScope() { depth()--; }
+        PrimaryReadScope(const PrimaryReadScope&) = delete;
+        PrimaryReadScope& operator=(const PrimaryReadScope&) = delete;
 
-        while (connections_.empty() && connections_count_ >= max_connections_) {
-            conn_available_.wait(lock);
-        }
+        static bool active() { return depth() > 0; }
 
-        if (!connections_.empty()) {
-            auto conn = connections_.front();
-            connections_.pop();
-            return conn;
+    private:
+        static int& depth() {
+            thread_local int depth = 0;
+            return depth;
         }
+    };
 
-        auto conn = CreateConnection();
-        connections_count_++;
-        return conn;
+    /*
+    Lease a primary connection, site names the caller (see PoolSite)
+    */
+    PooledConnection getConnection(const PoolSite& site = PoolSite::unknown()) {
+        return primary_->lease(site);
     }
 
     /*
-    Release connection ptr to the pool, param is the connection ptr
+    Lease a primary connection for a write made on behalf of session,
+    and pin that session's reads to the primary
     */
-    void releaseConnection(const std::shared_ptr<pqxx::connection>& conn) {
-        std::unique_lock<std::mutex> lock(mutex_);
-        connections_.push(conn);
-        conn_available_.notify_one();
+    PooledConnection getWriteConnection(const PoolSite& site = PoolSite::unknown(),
+                                        std::int64_t session = DB_NO_SESSION) {
+        if (read_your_writes_.count() > 0) {
+            pinToPrimary(session, read_your_writes_);
+        }
+        return primary_->lease(site);
     }
-private:
-    std::queue<std::shared_ptr<pqxx::connection>> connections_;
-    std::mutex mutex_;
-    std::condition_variable conn_available_;
-    const int max_connections_{MAX_CONNECTIONS};
-    int connections_count_{0};
 
+    /*
+    Lease a connection for a read-only query, from the replica when one is
+    configured, session has not written recently and no PrimaryReadScope is active
+    */
+    PooledConnection getReadConnection(const PoolSite& site = PoolSite::unknown(),
+                                       std::int64_t session = DB_NO_SESSION) {
+        if (replica_ == nullptr || PrimaryReadScope::active() || isPinned(session)) {
+            return primary_->lease(site);
+        }
+        return replica_->lease(site);
+    }
 
-    DatabasePool() {
-        for (int i = 0; i < MAX_CONNECTIONS; i++) {
-            connections_.push(CreateConnection());
-            connections_count_++;
+    /*
+    Keep a session's reads on the primary for the given time,
+    e.g. for a session that must see writes made by another instance
+    */
+    void pinToPrimary(std::int64_t session, std::chrono::steady_clock::duration duration) {
+        if (session == DB_NO_SESSION) {
+            return;
+        }
+        const std::int64_t until = (std::chrono::steady_clock::now() + duration).time_since_epoch().count();
+        std::atomic<std::int64_t>& pin = pinSlot(session);
+        std::int64_t current = pin.load(std::memory_order_relaxed);
+        while (current < until && !pin.compare_exchange_weak(current, until, std::memory_order_relaxed)) {
         }
     }
 
-    static std::shared_ptr<pqxx::connection> CreateConnection() {
+    [[nodiscard]] bool hasReplica() const { return replica_ != nullptr; }
+
+    /*
+    Pool snapshots for a metrics endpoint or tests, replicaStats() is empty without a replica
+    */
+    PoolStats stats() const { return primary_->stats(); }
+    PoolStats replicaStats() const { return replica_ != nullptr ? replica_->stats() : PoolStats{}; }
+
+    /*
+    libpq connection string for the given server, with credentials from Config.
+    Used by the pool, AsyncExecutor and InvalidationListener. Every session
+    runs with DateStyle=ISO and TimeZone=UTC whatever the server or role
+    defaults are, since parseTimestamp() only reads ISO 8601 text.
+    */
+    static std::string connectionString(const std::string& host, const std::string& port) {
         Config& config = Config::getInstance();
-        std::string conn_str =
-            "dbname=" + config.get("DB_NAME") +
+        return "dbname=" + config.get("DB_NAME") +
             " user=" + config.get("DB_USER") +
-            " password" + config.get("DB_HOST") +
-            " port=" + config.get("DB_PORT");
+            " password=" + config.get("DB_PASSWORD") +
+            " host=" + host +
+            " port=" + port +
+            " options='-c DateStyle=ISO -c TimeZone=UTC'";
+    }
+
+private:
+    std::unique_ptr<ConnectionSet> primary_;
+    std::unique_ptr<ConnectionSet> replica_;
+    std::chrono::steady_clock::duration read_your_writes_;
+    std::unique_ptr<std::atomic<std::int64_t>[]> session_pins_{new std::atomic<std::int64_t>[DB_SESSION_PIN_SLOTS]{}};
 
-        return std::make_shared<pqxx::connection>(conn_str);
+    DatabasePool() {
+        Config& config = Config::getInstance();
+        const int min_connections = config.getInt("DB_POOL_MIN", 2);
+        const int max_connections = config.getInt("DB_POOL_MAX", 10);
+        const auto idle_timeout = std::chrono::seconds(std::max(1, config.getInt("DB_POOL_IDLE_TIMEOUT_SEC", 300)));
+        const auto ping_after = std::chrono::seconds(std::max(0, config.getInt("DB_POOL_PING_AFTER_SEC", 30)));
+        read_your_writes_ = std::chrono::milliseconds(std::max(0, config.getInt("DB_READ_YOUR_WRITES_MS", 1000)));
+
+        primary_ = std::make_unique<ConnectionSet>(
+            "primary",
+            connectionString(config.get("DB_HOST"), config.get("DB_PORT")),
+            min_connections, max_connections, idle_timeout, ping_after);
+
+        if (!config.get("DB_REPLICA_HOST").empty()) {
+            const std::string port = config.get("DB_REPLICA_PORT");
+            replica_ = std::make_unique<ConnectionSet>(
+                "replica",
+                connectionString(config.get("DB_REPLICA_HOST"), port.empty() ? config.get("DB_PORT") : port),
+                min_connections, max_connections, idle_timeout, ping_after);
+        }
+    }
+
+    std::atomic<std::int64_t>& pinSlot(std::int64_t session) const {
+        return session_pins_[std::hash<std::int64_t>{}(session) % DB_SESSION_PIN_SLOTS];
     }
+
+    bool isPinned(std::int64_t session) const {
+        return session != DB_NO_SESSION &&
+            std::chrono::steady_clock::now().time_since_epoch().count() <
+                pinSlot(session).load(std::memory_order_relaxed);
+    }
+
 };
+
+inline void PooledConnection::release() {
+    if (pool_ != nullptr) {
+        const auto held = std::chrono::steady_clock::now() - acquired_;
+        ConnectionSet* pool = std::exchange(pool_, nullptr);
+        slot_->metrics.hold_time.record(held);
+        slot_->metrics.site(site_).record(held);
+        pool->releaseSlot(std::exchange(slot_, nullptr));
+    }
+}
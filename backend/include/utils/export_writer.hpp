@@ -0,0 +1,111 @@
+// include/utils/export_writer.hpp
+
+#pragma once
+#include <cstddef>
+#include <initializer_list>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+#include <zlib.h>
+#include "utils/pool_metrics.hpp"
+#include "utils/row_mapper.hpp"
+
+#define EXPORT_BUFFER_SIZE (64 * 1024)
+
+enum class ExportFormat {
+    CSV,        // header line, then RFC 4180 quoting
+    NDJSON      // one JSON object per line
+};
+
+enum class ExportCompression {
+    NONE,
+    GZIP
+};
+
+struct ExportColumn {
+    const char* name;
+    bool numeric;       // written unquoted in NDJSON
+};
+
+// enums are stored as their integer code (e.g. BorrowingStatus)
+template <typename T>
+inline constexpr bool isNumericColumn = std::is_arithmetic_v<T> || std::is_enum_v<T>;
+
+/*
+Column list of an export, names from the table's *_COLUMNS macro and
+numeric flags from the member types of ModelTraits<Row>
+*/
+template <typename Row>
+std::vector<ExportColumn> exportColumns(std::initializer_list<const char*> names) {
+    std::vector<ExportColumn> columns;
+    auto name = names.begin();
+    std::apply([&columns, &name](auto... members) {
+        ((columns.push_back({*name++, isNumericColumn<std::remove_reference_t<decltype(std::declval<Row&>().*members)>>})), ...);
+    }, ModelTraits<Row>::members);
+    return columns;
+}
+
+/*
+Formats rows as CSV or NDJSON into a fixed-size buffer and hands full
+buffers to the output stream, optionally through gzip. Memory stays at
+two EXPORT_BUFFER_SIZE buffers however many rows are written.
+*/
+class ExportWriter {
+public:
+    ExportWriter(std::ostream& out, ExportFormat format, ExportCompression compression,
+                 std::vector<ExportColumn> columns);
+    ~ExportWriter();
+
+    ExportWriter(const ExportWriter&) = delete;
+    ExportWriter& operator=(const ExportWriter&) = delete;
+
+    /*
+    One row of text fields in column order, a field with data() == nullptr is NULL
+    (the convention of pqxx::stream_from::read_row)
+    */
+    template <typename Fields>
+    void writeRow(const Fields& fields) {
+        beginRow();
+        std::size_t col = 0;
+        for (const auto& field : fields) {
+            writeField(col++, std::string_view(field.data(), field.size()), field.data() == nullptr);
+        }
+        endRow();
+    }
+
+    // Flush everything, including the gzip trailer; returns false if the stream failed
+    bool finish();
+
+    [[nodiscard]] long rows() const { return rows_; }
+
+private:
+    void beginRow();
+    void writeField(std::size_t col, std::string_view value, bool is_null);
+    void endRow();
+
+    void appendCsv(std::string_view value);
+    void appendJsonString(std::string_view value);
+    void flush(bool final);
+
+    std::ostream& out_;
+    ExportFormat format_;
+    ExportCompression compression_;
+    std::vector<ExportColumn> columns_;
+
+    std::string buffer_;
+    std::vector<char> compressed_;
+    z_stream zstream_{};
+    bool finished_{false};
+    long rows_{0};
+};
+
+/*
+Run query on a read connection and stream every row into writer through
+pqxx::stream_from (COPY ... TO STDOUT). Returns the number of rows, -1 on error.
+*/
+long exportQuery(const std::string& query, const PoolSite& site, ExportWriter& writer);
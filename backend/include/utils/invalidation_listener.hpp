@@ -0,0 +1,102 @@
+// include/utils/invalidation_listener.hpp
+
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <libpq-fe.h>
+
+/*
+Cross-instance cache invalidation over PostgreSQL LISTEN/NOTIFY.
+
+Triggers in database/init.sql send "<table>:<id>" on DB_NOTIFY_CHANNEL for
+every committed change to books, users and borrowing_records (for
+borrowing_records the id is the book_id, whose availability changed).
+A books update that only changes available_copies is sent as
+"book_availability:<id>" so subscribers can keep the rest of the row.
+The listener owns one dedicated libpq connection outside DatabasePool and
+a thread that poll()s it. Notifications arriving within DB_NOTIFY_BATCH_MS
+of each other are deduplicated per table and handed to subscribers as one
+batch of ids. "<table>:*" (sent once by bulk writes such as BookImport
+instead of one notification per row) resets that table's subscribers.
+
+If the connection drops, notifications sent meanwhile are lost, so after
+every reconnect subscribers get onReset() and must drop everything they hold.
+
+Handlers run on the listener thread and must not block.
+*/
+class InvalidationListener {
+public:
+    using BatchHandler = std::function<void(const std::vector<int>& ids)>;
+    using ResetHandler = std::function<void()>;
+
+    static InvalidationListener& getInstance() {
+        static InvalidationListener instance;
+        return instance;
+    }
+
+    InvalidationListener(const InvalidationListener&) = delete;
+    InvalidationListener& operator=(const InvalidationListener&) = delete;
+    ~InvalidationListener();
+
+    /*
+    Call on_batch with the changed ids of `table`, and on_reset whenever
+    notifications may have been missed. The listener thread starts with the
+    first subscription. Returns an id for unsubscribe().
+    */
+    int subscribe(const std::string& table, BatchHandler on_batch, ResetHandler on_reset);
+    void unsubscribe(int subscription);
+
+    // Notifications applied and reconnects since startup, for metrics
+    [[nodiscard]] std::uint64_t notificationsReceived() const;
+    [[nodiscard]] std::uint64_t batchesApplied() const;
+    [[nodiscard]] std::uint64_t resets() const;
+
+private:
+    struct Subscription {
+        std::string table;
+        BatchHandler on_batch;
+        ResetHandler on_reset;
+    };
+
+    // Notifications collected within one batch window
+    struct PendingBatch {
+        std::map<std::string, std::set<int>> ids;
+        std::set<std::string> cleared;      // tables notified with "<table>:*"
+
+        [[nodiscard]] bool empty() const { return ids.empty() && cleared.empty(); }
+        void clear() { ids.clear(); cleared.clear(); }
+    };
+
+    InvalidationListener();
+
+    void listenLoop();
+    bool connect();
+    void disconnect();
+    void collect(PendingBatch& pending);
+    void apply(PendingBatch& pending);
+    void reset();
+    void wake();
+
+    std::string conn_str_;
+    std::string channel_;
+    int batch_ms_;
+
+    PGconn* conn_{nullptr};     // only touched by the listener thread
+
+    mutable std::mutex mutex_;
+    std::map<int, Subscription> subscriptions_;
+    int next_subscription_{1};
+    bool stopping_{false};
+    std::uint64_t notifications_{0};
+    std::uint64_t batches_{0};
+    std::uint64_t resets_{0};
+
+    int wake_fds_[2]{-1, -1};
+    std::thread listen_thread_;
+};
@@ -0,0 +1,177 @@
+// include/utils/lru_cache.hpp
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+Point-in-time view of a cache, counters are totals since startup
+*/
+struct CacheStats {
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};
+    std::uint64_t insertions{0};
+    std::uint64_t evictions{0};         // dropped to stay within capacity
+    std::uint64_t invalidations{0};     // removed by erase()/clear()
+    std::size_t entries{0};
+    std::size_t capacity{0};
+
+    [[nodiscard]] double hitRate() const {
+        auto lookups = hits + misses;
+        return lookups == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(lookups);
+    }
+};
+
+/*
+Bounded LRU map split into independently locked shards, so concurrent
+lookups of different keys rarely contend. Each shard keeps its own
+recency list and evicts its least recently used entry when full.
+Values are returned by copy; store shared_ptr<const T> for large values.
+*/
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedLruCache {
+public:
+    ShardedLruCache(std::size_t capacity, std::size_t shard_count)
+        : capacity_(capacity)
+    {
+        shard_count = shard_count == 0 ? 1 : shard_count;
+        std::size_t per_shard = (capacity + shard_count - 1) / shard_count;
+        shards_.reserve(shard_count);
+        for (std::size_t i = 0; i < shard_count; i++) {
+            shards_.push_back(std::make_unique<Shard>(per_shard == 0 ? 1 : per_shard));
+        }
+    }
+
+    ShardedLruCache(const ShardedLruCache&) = delete;
+    ShardedLruCache& operator=(const ShardedLruCache&) = delete;
+
+    std::optional<Value> get(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto found = shard.index.find(key);
+        if (found == shard.index.end()) {
+            misses_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return found->second->second;
+    }
+
+    void put(const Key& key, Value value) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        putLocked(shard, key, std::move(value));
+    }
+
+    /*
+    Store value only if keep() still returns true, evaluated under the shard lock.
+    An erase() of the same key is ordered either before the check or after the
+    insert, so a writer that invalidates and then erases never leaves a stale fill.
+    */
+    template <typename Keep>
+    bool putIf(const Key& key, Value value, Keep&& keep) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (!keep()) {
+            return false;
+        }
+        putLocked(shard, key, std::move(value));
+        return true;
+    }
+
+    bool erase(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto found = shard.index.find(key);
+        if (found == shard.index.end()) {
+            return false;
+        }
+        shard.entries.erase(found->second);
+        shard.index.erase(found);
+        invalidations_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void clear() {
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            invalidations_.fetch_add(shard->entries.size(), std::memory_order_relaxed);
+            shard->index.clear();
+            shard->entries.clear();
+        }
+    }
+
+    [[nodiscard]] CacheStats stats() const {
+        CacheStats stats;
+        stats.hits = hits_.load(std::memory_order_relaxed);
+        stats.misses = misses_.load(std::memory_order_relaxed);
+        stats.insertions = insertions_.load(std::memory_order_relaxed);
+        stats.evictions = evictions_.load(std::memory_order_relaxed);
+        stats.invalidations = invalidations_.load(std::memory_order_relaxed);
+        stats.capacity = capacity_;
+        for (const auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            stats.entries += shard->entries.size();
+        }
+        return stats;
+    }
+
+private:
+    using Entries = std::list<std::pair<Key, Value>>;
+
+    struct Shard {
+        explicit Shard(std::size_t shard_capacity) : capacity(shard_capacity) {}
+
+        mutable std::mutex mutex;
+        Entries entries;    // most recently used first
+        std::unordered_map<Key, typename Entries::iterator, Hash> index;
+        std::size_t capacity;
+    };
+
+    // caller holds shard.mutex
+    void putLocked(Shard& shard, const Key& key, Value value) {
+        auto found = shard.index.find(key);
+        if (found != shard.index.end()) {
+            found->second->second = std::move(value);
+            shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+            return;
+        }
+
+        if (shard.entries.size() >= shard.capacity) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.entries.emplace_front(key, std::move(value));
+        shard.index.emplace(key, shard.entries.begin());
+        insertions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Shard& shardFor(const Key& key) {
+        // mix the hash first: std::hash<int> is the identity, which would put
+        // consecutive ids in consecutive shards and leave each shard's own map skewed
+        auto hash = static_cast<std::uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+        return *shards_[static_cast<std::size_t>(hash >> 32) % shards_.size()];
+    }
+
+    std::size_t capacity_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> insertions_{0};
+    std::atomic<std::uint64_t> evictions_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+};
@@ -0,0 +1,94 @@
+// include/utils/page_cursor.hpp
+
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/*
+Position of a keyset page: the (key, id) of the last row already returned.
+The next page is `WHERE (key, id) > ($key, $id) ORDER BY key, id`, so every
+page costs one index range scan no matter how deep it is.
+
+Clients only see the opaque token from encode(), base64url of "id:key".
+*/
+struct PageCursor {
+    std::string key;
+    int id{0};
+
+    [[nodiscard]] std::string encode() const {
+        return base64UrlEncode(std::to_string(id) + ":" + key);
+    }
+
+    // std::nullopt for tokens we did not issue
+    static std::optional<PageCursor> decode(std::string_view token) {
+        auto text = base64UrlDecode(token);
+        if (!text) {
+            return std::nullopt;
+        }
+
+        auto colon = text->find(':');
+        if (colon == std::string::npos) {
+            return std::nullopt;
+        }
+
+        PageCursor cursor;
+        auto [ptr, ec] = std::from_chars(text->data(), text->data() + colon, cursor.id);
+        if (ec != std::errc() || ptr != text->data() + colon || cursor.id <= 0) {
+            return std::nullopt;
+        }
+        cursor.key = text->substr(colon + 1);
+        return cursor;
+    }
+
+private:
+    static constexpr const char* ALPHABET =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    static std::string base64UrlEncode(std::string_view input) {
+        std::string output;
+        output.reserve((input.size() + 2) / 3 * 4);
+
+        std::uint32_t buffer = 0;
+        int bits = 0;
+        for (unsigned char c : input) {
+            buffer = (buffer << 8) | c;
+            bits += 8;
+            while (bits >= 6) {
+                bits -= 6;
+                output.push_back(ALPHABET[(buffer >> bits) & 0x3F]);
+            }
+        }
+        if (bits > 0) {
+            output.push_back(ALPHABET[(buffer << (6 - bits)) & 0x3F]);
+        }
+        return output;
+    }
+
+    static std::optional<std::string> base64UrlDecode(std::string_view input) {
+        std::string output;
+        output.reserve(input.size() * 3 / 4);
+
+        std::uint32_t buffer = 0;
+        int bits = 0;
+        for (char c : input) {
+            int value = -1;
+            if (c >= 'A' && c <= 'Z') value = c - 'A';
+            else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+            else if (c >= '0' && c <= '9') value = c - '0' + 52;
+            else if (c == '-') value = 62;
+            else if (c == '_') value = 63;
+            else return std::nullopt;
+
+            buffer = (buffer << 6) | static_cast<std::uint32_t>(value);
+            bits += 6;
+            if (bits >= 8) {
+                bits -= 8;
+                output.push_back(static_cast<char>((buffer >> bits) & 0xFF));
+            }
+        }
+        return output;
+    }
+};
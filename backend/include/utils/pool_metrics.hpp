@@ -0,0 +1,257 @@
+// include/utils/pool_metrics.hpp
+
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+#define POOL_MAX_SITES 128      // distinct lease call sites with their own histogram, the rest share "other"
+
+/*
+Lock-free latency histogram with power-of-two microsecond buckets.
+Bucket i counts samples in [2^(i-1), 2^i) us, bucket 0 counts samples
+under 1 us and the last bucket everything above ~35 minutes.
+*/
+class LatencyHistogram {
+public:
+    static constexpr std::size_t BUCKETS = 32;
+
+    struct Snapshot {
+        std::uint64_t count{0};
+        std::uint64_t sum_us{0};
+        std::uint64_t max_us{0};
+        std::array<std::uint64_t, BUCKETS> buckets{};
+
+            void merge(const Snapshot& other) {
+            count += other.count;
+            sum_us += other.sum_us;
+            max_us = std::max(max_us, other.max_us);
+            for (std::size_t i = 0; i < BUCKETS; i++) {
+                buckets[i] += other.buckets[i];
+            }
+        }
+
+        [[nodiscard]] double mean_us() const {
+            return count == 0 ? 0.0 : static_cast<double>(sum_us) / static_cast<double>(count);
+        }
+
+        /*
+        Upper bound of the bucket holding the given percentile (0-100)
+        */
+        [[nodiscard]] std::uint64_t percentile_us(double pct) const {
+            if (count == 0) {
+                return 0;
+            }
+            auto rank = static_cast<std::uint64_t>(static_cast<double>(count) * pct / 100.0);
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < BUCKETS; i++) {
+                seen += buckets[i];
+                if (seen > rank) {
+                    return bucketUpperBound(i);
+                }
+            }
+            return max_us;
+        }
+    };
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        auto value = us > 0 ? static_cast<std::uint64_t>(us) : 0;
+
+        buckets_[bucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+        count_.fetch_add(1, std::memory_order_relaxed);
+        sum_us_.fetch_add(value, std::memory_order_relaxed);
+
+        std::uint64_t prev = max_us_.load(std::memory_order_relaxed);
+        while (value > prev && !max_us_.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    [[nodiscard]] Snapshot snapshot() const {
+        Snapshot snap;
+        snap.count = count_.load(std::memory_order_relaxed);
+        snap.sum_us = sum_us_.load(std::memory_order_relaxed);
+        snap.max_us = max_us_.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < BUCKETS; i++) {
+            snap.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+        }
+        return snap;
+    }
+
+    static std::uint64_t bucketUpperBound(std::size_t bucket) {
+        return std::uint64_t{1} << bucket;
+    }
+
+private:
+    static std::size_t bucketFor(std::uint64_t us) {
+        std::size_t bucket = 0;
+        while (us != 0 && bucket < BUCKETS - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    std::array<std::atomic<std::uint64_t>, BUCKETS> buckets_{};
+    std::atomic<std::uint64_t> count_{0};
+    std::atomic<std::uint64_t> sum_us_{0};
+    std::atomic<std::uint64_t> max_us_{0};
+};
+
+/*
+Point-in-time view of the pool, returned by DatabasePool::stats()
+*/
+struct PoolStats {
+    // gauges
+    int max_connections{0};
+    int open_connections{0};
+    int in_use{0};
+    int idle{0};
+    int waiters{0};
+
+    // counters since startup
+    std::uint64_t acquires{0};
+    std::uint64_t connections_created{0};
+    std::uint64_t creation_failures{0};
+    std::uint64_t reconnects{0};
+    std::uint64_t idle_evictions{0};
+
+    LatencyHistogram::Snapshot acquire_wait;
+    LatencyHistogram::Snapshot hold_time;
+    std::map<std::string, LatencyHistogram::Snapshot> hold_time_by_site;
+};
+
+/*
+Call site of a pool lease, e.g. "Book::search".
+The name is registered once and resolved to a small index, so recording
+a lease is an array access. Declare sites as function-local statics:
+
+    static const PoolSite site("Book::search");
+    auto conn = DatabasePool::getInstance().getReadConnection(site);
+*/
+class PoolSite {
+public:
+    explicit PoolSite(std::string_view name) : index_(registry().add(name)) {}
+
+    [[nodiscard]] std::size_t index() const { return index_; }
+    [[nodiscard]] const std::string& name() const { return registry().names[index_]; }
+
+    static const std::string& nameOf(std::size_t index) { return registry().names[index]; }
+
+    static const PoolSite& unknown() {
+        static const PoolSite site("unknown");
+        return site;
+    }
+
+private:
+    struct Registry {
+        std::mutex mutex;
+        std::size_t count{0};
+        std::array<std::string, POOL_MAX_SITES> names;
+
+        Registry() { names[POOL_MAX_SITES - 1] = "other"; }
+
+        std::size_t add(std::string_view name) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (std::size_t i = 0; i < count; i++) {
+                if (names[i] == name) {
+                    return i;
+                }
+            }
+            if (count == POOL_MAX_SITES - 1) {
+                return POOL_MAX_SITES - 1;
+            }
+            names[count] = std::string(name);
+            return count++;
+        }
+    };
+
+    static Registry& registry() {
+        static Registry instance;
+        return instance;
+    }
+
+    std::size_t index_;
+};
+
+inline std::ostream& operator<<(std::ostream& os, const PoolSite& site) {
+    return os << site.name();
+}
+
+/*
+Counters and histograms of one pool slot.
+Only the thread holding the slot records into them, so a lease touches
+no cache line shared with other threads; stats() sums all slots.
+Per-site histograms are allocated on the first lease from that site.
+*/
+class SlotMetrics {
+public:
+    SlotMetrics() = default;
+    SlotMetrics(const SlotMetrics&) = delete;
+    SlotMetrics& operator=(const SlotMetrics&) = delete;
+
+    ~SlotMetrics() {
+        for (auto& site : sites_) {
+            delete site.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::atomic<std::uint64_t> acquires{0};
+    LatencyHistogram acquire_wait;
+    LatencyHistogram hold_time;
+
+    /*
+    Histogram for one call site, only called by the slot holder
+    */
+    LatencyHistogram& site(std::size_t index) {
+        LatencyHistogram* histogram = sites_[index].load(std::memory_order_relaxed);
+        if (histogram == nullptr) {
+            histogram = new LatencyHistogram();
+            sites_[index].store(histogram, std::memory_order_release);
+        }
+        return *histogram;
+    }
+
+    void fill(PoolStats& stats) const {
+        stats.acquires += acquires.load(std::memory_order_relaxed);
+        stats.acquire_wait.merge(acquire_wait.snapshot());
+        stats.hold_time.merge(hold_time.snapshot());
+
+        for (std::size_t i = 0; i < POOL_MAX_SITES; i++) {
+            if (const LatencyHistogram* histogram = sites_[i].load(std::memory_order_acquire)) {
+                stats.hold_time_by_site[PoolSite::nameOf(i)].merge(histogram->snapshot());
+            }
+        }
+    }
+
+private:
+    std::array<std::atomic<LatencyHistogram*>, POOL_MAX_SITES> sites_{};
+};
+
+/*
+Connection lifecycle counters of a ConnectionSet.
+These move only on connect, reconnect and eviction; per-lease
+counters live in SlotMetrics.
+*/
+class PoolMetrics {
+public:
+    std::atomic<std::uint64_t> connections_created{0};
+    std::atomic<std::uint64_t> creation_failures{0};
+    std::atomic<std::uint64_t> reconnects{0};
+    std::atomic<std::uint64_t> idle_evictions{0};
+
+    void fill(PoolStats& stats) const {
+        stats.connections_created = connections_created.load(std::memory_order_relaxed);
+        stats.creation_failures = creation_failures.load(std::memory_order_relaxed);
+        stats.reconnects = reconnects.load(std::memory_order_relaxed);
+        stats.idle_evictions = idle_evictions.load(std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,102 @@
+// include/utils/response_cache.hpp
+
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include "utils/lru_cache.hpp"
+
+/*
+An already-serialized JSON response. body is shared with the cache, so a
+hit costs no copy; on a conditional hit (304) body is null.
+*/
+struct SerializedResponse {
+    int status{200};
+    std::string etag;
+    std::shared_ptr<const std::string> body;
+};
+
+/*
+Serialized responses keyed by (endpoint, params), each stamped with the
+data version it was built from. A lookup with a newer version misses, so
+entries never outlive the data: no TTL, no explicit purge.
+*/
+class ResponseCache {
+public:
+    ResponseCache(std::size_t capacity, std::size_t shards) : entries_(capacity, shards) {}
+
+    /*
+    Cached response for key at version, nullptr on a miss. if_none_match is
+    the request's If-None-Match header; when it names the cached ETag the
+    result is a 304 without a body.
+    */
+    std::unique_ptr<SerializedResponse> get(const std::string& key, std::uint64_t version,
+                                            std::string_view if_none_match = {}) {
+        auto cached = entries_.get(key);
+        if (!cached || (*cached)->version != version) {
+            return nullptr;
+        }
+        return respond(**cached, if_none_match);
+    }
+
+    /*
+    Store body as built from data at version and answer the request with it
+    */
+    std::unique_ptr<SerializedResponse> put(const std::string& key, std::uint64_t version,
+                                            std::string body, std::string_view if_none_match = {}) {
+        auto entry = std::make_shared<Entry>();
+        entry->version = version;
+        entry->etag = makeEtag(body);
+        entry->body = std::make_shared<const std::string>(std::move(body));
+        entries_.put(key, entry);
+        return respond(*entry, if_none_match);
+    }
+
+    [[nodiscard]] CacheStats stats() const { return entries_.stats(); }
+
+    // Strong ETag: quoted 64-bit FNV-1a of the body
+    static std::string makeEtag(std::string_view body) {
+        std::uint64_t hash = 0xcbf29ce484222325ull;
+        for (unsigned char c : body) {
+            hash ^= c;
+            hash *= 0x100000001b3ull;
+        }
+        char buffer[24];
+        std::snprintf(buffer, sizeof(buffer), "\"%016llx\"", static_cast<unsigned long long>(hash));
+        return buffer;
+    }
+
+    // If-None-Match may be "*" or a comma-separated list of (possibly weak) tags
+    static bool matches(std::string_view if_none_match, std::string_view etag) {
+        if (if_none_match.empty()) {
+            return false;
+        }
+        if (if_none_match == "*") {
+            return true;
+        }
+        return if_none_match.find(etag) != std::string_view::npos;
+    }
+
+private:
+    struct Entry {
+        std::uint64_t version{0};
+        std::string etag;
+        std::shared_ptr<const std::string> body;
+    };
+
+    static std::unique_ptr<SerializedResponse> respond(const Entry& entry, std::string_view if_none_match) {
+        auto response = std::make_unique<SerializedResponse>();
+        response->etag = entry.etag;
+        if (matches(if_none_match, entry.etag)) {
+            response->status = 304;
+        } else {
+            response->body = entry.body;
+        }
+        return response;
+    }
+
+    ShardedLruCache<std::string, std::shared_ptr<const Entry>> entries_;
+};
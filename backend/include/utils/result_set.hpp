@@ -0,0 +1,102 @@
+// include/utils/result_set.hpp
+
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+#include "utils/row_mapper.hpp"
+
+/*
+Read-only rows of a list query, stored contiguously.
+
+Row is a plain struct (e.g. BookRow) mapped through ModelTraits<Row> like
+the models. Rows sit back to back in one vector and their string fields are
+string_views into a per-query arena, so hydrating N rows costs a few arena
+chunks instead of N heap nodes plus one allocation per string.
+
+Views stay valid for the lifetime of the ResultSet, moves included.
+*/
+template <typename Row>
+class ResultSet {
+public:
+    using const_iterator = typename std::pmr::vector<Row>::const_iterator;
+
+    // Arena bytes reserved per row up front; longer rows just take another chunk
+    static constexpr std::size_t ARENA_BYTES_PER_ROW = 128;
+
+    ResultSet() : state_(std::make_unique<State>(ARENA_BYTES_PER_ROW)) {}
+
+    static ResultSet from(const pqxx::result& result) {
+        ResultSet set(result.size());
+        set.append(result);
+        return set;
+    }
+
+    /*
+    Append the rows of another result, e.g. the next batch of a cursor
+    */
+    void append(const pqxx::result& result) {
+        state_->rows.reserve(state_->rows.size() + result.size());
+        for (const auto& row : result) {
+            bind(state_->rows.emplace_back(), row, std::make_index_sequence<COLUMNS>{});
+        }
+    }
+
+    void clear() {
+        // the arena only grows; drop it with the rows so batches reuse bounded memory
+        state_ = std::make_unique<State>(ARENA_BYTES_PER_ROW * std::max<std::size_t>(state_->rows.size(), 1));
+    }
+
+    [[nodiscard]] bool empty() const { return state_->rows.empty(); }
+    [[nodiscard]] std::size_t size() const { return state_->rows.size(); }
+    [[nodiscard]] const Row& operator[](std::size_t index) const { return state_->rows[index]; }
+    [[nodiscard]] const Row& back() const { return state_->rows.back(); }
+    [[nodiscard]] const_iterator begin() const { return state_->rows.begin(); }
+    [[nodiscard]] const_iterator end() const { return state_->rows.end(); }
+
+private:
+    static constexpr std::size_t COLUMNS = std::tuple_size_v<decltype(ModelTraits<Row>::members)>;
+
+    struct State {
+        explicit State(std::size_t arena_bytes) : arena(arena_bytes), rows(&arena) {}
+
+        std::pmr::monotonic_buffer_resource arena;
+        std::pmr::vector<Row> rows;     // allocated from the arena as well
+    };
+
+    explicit ResultSet(std::size_t expected_rows)
+        : state_(std::make_unique<State>(ARENA_BYTES_PER_ROW * std::max<std::size_t>(expected_rows, 1))) {}
+
+    std::string_view store(std::string_view text) {
+        if (text.empty()) {
+            return {};
+        }
+        auto* data = static_cast<char*>(state_->arena.allocate(text.size(), alignof(char)));
+        std::memcpy(data, text.data(), text.size());
+        return {data, text.size()};
+    }
+
+    template <std::size_t... I>
+    void bind(Row& out, const pqxx::row& row, std::index_sequence<I...>) {
+        (assign(out.*std::get<I>(ModelTraits<Row>::members), row[static_cast<pqxx::row::size_type>(I)]), ...);
+    }
+
+    template <typename T>
+    void assign(T& out, const pqxx::field& field) {
+        out = FieldReader<T>::read(field);
+    }
+
+    void assign(std::string_view& out, const pqxx::field& field) {
+        out = field.is_null() ? std::string_view() : store(field.view());
+    }
+
+    // heap-held so moving a ResultSet never moves the arena the views point into
+    std::unique_ptr<State> state_;
+};
@@ -0,0 +1,161 @@
+// include/utils/row_mapper.hpp
+
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <pqxx/pqxx>
+#include "utils/timestamp.hpp"
+
+/*
+Member list of a model, specialized next to the model's queries:
+
+    template <>
+    struct ModelTraits<Book> {
+        static constexpr auto members = std::make_tuple(&Book::id_, &Book::isbn_, ...);
+    };
+
+members follow the SELECT list generated from the same *_COLUMNS macro in
+utils/statements.hpp, so RowMapper binds every field by column index.
+*/
+template <typename Model>
+struct ModelTraits;
+
+/*
+Null-safe conversion of a single column; NULL becomes the member's default value
+*/
+template <typename T>
+struct FieldReader;
+
+template <>
+struct FieldReader<int> {
+    static int read(const pqxx::field& field) {
+        return field.is_null() ? 0 : field.as<int>();
+    }
+
+    static int parse(std::string_view text) {
+        if (text.empty()) {
+            return 0;
+        }
+        int value = 0;
+        auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec != std::errc() || ptr != text.data() + text.size()) {
+            throw std::runtime_error("FieldReader<int>::parse(): not an integer");
+        }
+        return value;
+    }
+};
+
+template <>
+struct FieldReader<std::string> {
+    static std::string read(const pqxx::field& field) {
+        return field.is_null() ? std::string() : field.as<std::string>();
+    }
+
+    static std::string parse(std::string_view text) {
+        return std::string(text);
+    }
+};
+
+// timestamptz columns are parsed once at hydration; NULL becomes the epoch
+template <>
+struct FieldReader<Timestamp> {
+    static Timestamp read(const pqxx::field& field) {
+        return field.is_null() ? Timestamp{} : parse(field.view());
+    }
+
+    static Timestamp parse(std::string_view text) {
+        if (text.empty()) {
+            return Timestamp{};
+        }
+        auto value = parseTimestamp(text);
+        if (!value) {
+            throw std::runtime_error("FieldReader<Timestamp>::parse(): not a timestamp");
+        }
+        return *value;
+    }
+};
+
+// nullable timestamptz columns, e.g. return_date
+template <>
+struct FieldReader<std::optional<Timestamp>> {
+    static std::optional<Timestamp> read(const pqxx::field& field) {
+        if (field.is_null()) {
+            return std::nullopt;
+        }
+        return FieldReader<Timestamp>::parse(field.view());
+    }
+
+    static std::optional<Timestamp> parse(std::string_view text) {
+        if (text.empty()) {
+            return std::nullopt;
+        }
+        return FieldReader<Timestamp>::parse(text);
+    }
+};
+
+/*
+Hydrates models straight from query rows, without the validating Builder:
+rows coming back from the database are trusted.
+*/
+template <typename Model>
+class RowMapper {
+public:
+    static constexpr std::size_t COLUMNS = std::tuple_size_v<decltype(ModelTraits<Model>::members)>;
+
+    /*
+    Map the columns starting at `offset`, so a join row can hold several models side by side
+    */
+    static std::unique_ptr<Model> map(const pqxx::row& row, pqxx::row::size_type offset = 0) {
+        std::unique_ptr<Model> model(new Model());
+        bind(*model, row, offset, std::make_index_sequence<COLUMNS>{});
+        return model;
+    }
+
+    static std::vector<std::unique_ptr<Model>> mapAll(const pqxx::result& result) {
+        std::vector<std::unique_ptr<Model>> models;
+        models.reserve(result.size());
+        for (const auto& row : result) {
+            models.push_back(map(row));
+        }
+        return models;
+    }
+
+    /*
+    Map text-format columns, get(i) returns column i as a string_view (e.g. AsyncResult)
+    */
+    template <typename Getter>
+    static std::unique_ptr<Model> parse(Getter&& get) {
+        std::unique_ptr<Model> model(new Model());
+        parseAll(*model, get, std::make_index_sequence<COLUMNS>{});
+        return model;
+    }
+
+private:
+    template <std::size_t... I>
+    static void bind(Model& model, const pqxx::row& row, pqxx::row::size_type offset, std::index_sequence<I...>) {
+        (assign(model, std::get<I>(ModelTraits<Model>::members), row[offset + static_cast<pqxx::row::size_type>(I)]), ...);
+    }
+
+    template <typename Getter, std::size_t... I>
+    static void parseAll(Model& model, Getter& get, std::index_sequence<I...>) {
+        (assignText(model, std::get<I>(ModelTraits<Model>::members), get(static_cast<int>(I))), ...);
+    }
+
+    template <typename T>
+    static void assign(Model& model, T Model::*member, const pqxx::field& field) {
+        model.*member = FieldReader<T>::read(field);
+    }
+
+    template <typename T>
+    static void assignText(Model& model, T Model::*member, std::string_view text) {
+        model.*member = FieldReader<T>::parse(text);
+    }
+};
@@ -0,0 +1,278 @@
+// include/utils/statements.hpp
+
+#pragma once
+#include <pqxx/pqxx>
+
+/*
+Mapped columns of each table, declared once. `id` always comes first and is
+not listed; SQL_SELECT_LIST builds the SELECT list from them, and each model's
+ModelTraits builds its member list from them (see utils/row_mapper.hpp).
+*/
+#define BOOK_COLUMNS(X)                                                                         \
+    X(isbn) X(title) X(author) X(publisher) X(publish_date) X(category)                         \
+    X(total_copies) X(available_copies)
+
+#define BORROWING_COLUMNS(X)                                                                    \
+    X(user_id) X(book_id) X(borrow_date) X(due_date) X(return_date) X(status)
+
+#define USER_COLUMNS(X)                                                                         \
+    X(username) X(email) X(password_hash) X(role)
+
+#define SQL_COLUMN_NAME(column) ", " #column
+#define SQL_SELECT_LIST(COLUMNS) "id" COLUMNS(SQL_COLUMN_NAME)
+
+// Alias-qualified select list entries for joins, e.g. "SELECT r.id" BORROWING_COLUMNS(SQL_BORROWING_COLUMN)
+#define SQL_BORROWING_COLUMN(column) ", r." #column
+#define SQL_BOOK_COLUMN(column) ", b." #column
+// Fields of the loan OUT parameter of borrow_book(), see database/init.sql
+#define SQL_LOAN_COLUMN(column) ", (loan)." #column
+
+// Column names as a braced list, e.g. {SQL_COLUMN_LABELS(BOOK_COLUMNS)}
+#define SQL_COLUMN_LABEL(column) , #column
+#define SQL_COLUMN_LABELS(COLUMNS) "id" COLUMNS(SQL_COLUMN_LABEL)
+
+// Integer constant as SQL text, e.g. "status = " SQL_LITERAL(BORROWING_STATUS_BORROWED)
+#define SQL_LITERAL(value) SQL_LITERAL_TEXT(value)
+#define SQL_LITERAL_TEXT(value) #value
+
+/*
+borrowing_records.status codes. BorrowingStatus (models/borrowing_record.hpp)
+takes its values from these and the statements below embed them with
+SQL_LITERAL, so C++ and the prepared SQL cannot drift apart. The SQL
+files repeat them as literals and must be kept in step by hand:
+database/init.sql (CHECK constraint, idx_borrowing_overdue, borrow_book,
+return_book) and migrations 001 and 009.
+*/
+#define BORROWING_STATUS_BORROWED 0
+#define BORROWING_STATUS_RETURNED 1
+#define BORROWING_STATUS_OVERDUE 2
+#define BORROWING_STATUS_RENEWED 3
+
+/*
+Catalog of every SQL statement the models run.
+Each entry is (name, sql); DatabasePool prepares the whole catalog once
+per connection, and models execute them with
+    txn.exec_prepared(Stmt::book_find_by_id, book_id);
+so PostgreSQL parses and plans each statement only once per connection.
+*/
+#define LIBRARY_STATEMENTS(X)                                                                   \
+    /* books */                                                                                 \
+    X(book_find_by_id,                                                                          \
+      "SELECT " SQL_SELECT_LIST(BOOK_COLUMNS) " FROM books WHERE id = $1")                      \
+    X(book_find_by_isbn,                                                                        \
+      "SELECT " SQL_SELECT_LIST(BOOK_COLUMNS) " FROM books WHERE isbn = $1")                    \
+    X(book_page_first,                                                                          \
+      "SELECT " SQL_SELECT_LIST(BOOK_COLUMNS) " FROM books "                                    \
+      "ORDER BY title, id LIMIT $1")                                                            \
+    X(book_page_after,                                                                          \
+      "SELECT " SQL_SELECT_LIST(BOOK_COLUMNS) " FROM books "                                    \
+      "WHERE (title, id) > ($1, $2) ORDER BY title, id LIMIT $3")                               \
+    X(book_search,                                                                              \
+      "SELECT " SQL_SELECT_LIST(BOOK_COLUMNS) " FROM books "                                    \
+      "WHERE title ILIKE $1 "                                                                   \
+      "   OR author ILIKE $1 "                                                                  \
+      "   OR isbn ILIKE $1 "                                                                    \
+      "   OR publisher ILIKE $1 "                                                               \
+      "   OR category ILIKE $1 "                                                                \
+      "ORDER BY "                                                                               \
+      "   CASE "                                                                                \
+      "       WHEN title ILIKE $1 THEN 1 "                                                      \
+      "       WHEN author ILIKE $1 THEN 2 "                                                     \
+      "       WHEN isbn = $2 THEN 3 "                                                           \
+      "       ELSE 4 "                                                                          \
+      "   END, "                                                                                \
+      "   title ASC "                                                                           \
+      "LIMIT 100")                                                                              \
+    X(book_count,                                                                               \
+      "SELECT COALESCE(SUM(books), 0) FROM catalog_counters")                                   \
+    X(book_counters_by_category,                                                                \
+      "SELECT category, SUM(books), SUM(total_copies), SUM(available_copies) "                  \
+      "FROM catalog_counters GROUP BY category HAVING SUM(books) > 0 ORDER BY category")        \
+    X(book_isbn_exists,                                                                         \
+      "SELECT id FROM books WHERE isbn = $1")                                                   \
+    X(book_isbn_conflict,                                                                       \
+      "SELECT id FROM books WHERE isbn = $1 AND id != $2")                                      \
+    X(book_insert,                                                                              \
+      "INSERT INTO books (isbn, title, author, publisher, publish_date, "                       \
+      "category, total_copies, available_copies) "                                              \
+      "VALUES ($1, $2, $3, $4, $5, $6, $7, $8) RETURNING id")                                   \
+    X(book_update,                                                                              \
+      "UPDATE books SET isbn = $1, title = $2, author = $3, "                                   \
+      "publisher = $4, publish_date = $5, category = $6, "                                      \
+      "total_copies = $7, available_copies = $8 WHERE id = $9")                                 \
+    X(book_has_active_borrowings,                                                               \
+      "SELECT id FROM borrowing_records WHERE book_id = $1 AND return_date IS NULL")            \
+    X(book_delete,                                                                              \
+      "DELETE FROM books WHERE id = $1")                                                        \
+    X(book_take_copy,                                                                           \
+      "UPDATE books SET available_copies = available_copies - 1 "                               \
+      "WHERE id = $1 AND available_copies > 0 RETURNING available_copies")                      \
+    X(book_return_copy,                                                                         \
+      "UPDATE books SET available_copies = available_copies + 1 "                               \
+      "WHERE id = $1 AND available_copies < total_copies RETURNING available_copies")           \
+                                                                                                \
+    /* borrowing_records */                                                                     \
+    X(borrowing_find_by_id,                                                                     \
+      "SELECT " SQL_SELECT_LIST(BORROWING_COLUMNS) " FROM borrowing_records WHERE id = $1")     \
+    X(borrowing_find_by_user,                                                                   \
+      "SELECT " SQL_SELECT_LIST(BORROWING_COLUMNS) " FROM borrowing_records "                   \
+      "WHERE user_id = $1 ORDER BY borrow_date DESC")                                           \
+    X(borrowing_find_active,                                                                    \
+      "SELECT " SQL_SELECT_LIST(BORROWING_COLUMNS) " FROM borrowing_records "                   \
+      "WHERE user_id = $1 AND book_id = $2 AND return_date IS NULL "                            \
+      "ORDER BY borrow_date LIMIT 1")                                                           \
+    X(borrowing_find_by_book,                                                                   \
+      "SELECT " SQL_SELECT_LIST(BORROWING_COLUMNS) " FROM borrowing_records "                   \
+      "WHERE book_id = $1 ORDER BY borrow_date DESC")                                           \
+    X(borrowing_find_overdue,                                                                   \
+      "SELECT " SQL_SELECT_LIST(BORROWING_COLUMNS) " FROM borrowing_records "                   \
+      "WHERE return_date IS NULL AND due_date < CURRENT_TIMESTAMP "                             \
+      "AND status = " SQL_LITERAL(BORROWING_STATUS_BORROWED) " "                                \
+      "ORDER BY borrow_date DESC")                                                              \
+    X(borrowing_count_active_by_user,                                                           \
+      "SELECT COUNT(*) FROM borrowing_records "                                                 \
+      "WHERE user_id = $1 AND return_date IS NULL")                                             \
+    X(borrowing_count_overdue_by_user,                                                          \
+      "SELECT COUNT(*) FROM borrowing_records "                                                 \
+      "WHERE user_id = $1 AND return_date IS NULL AND due_date < CURRENT_TIMESTAMP")            \
+    X(borrowing_status_by_users,                                                                \
+      "SELECT user_id, COUNT(*) AS active_count, "                                              \
+      "COUNT(*) FILTER (WHERE due_date < CURRENT_TIMESTAMP) AS overdue_count "                  \
+      "FROM borrowing_records "                                                                 \
+      "WHERE user_id = ANY($1::int[]) AND return_date IS NULL "                                 \
+      "GROUP BY user_id")                                                                       \
+    X(borrowing_active_exists,                                                                  \
+      "SELECT id FROM borrowing_records "                                                       \
+      "WHERE user_id = $1 AND book_id = $2 AND return_date IS NULL")                            \
+    X(borrowing_insert,                                                                         \
+      "INSERT INTO borrowing_records (user_id, book_id, borrow_date, due_date, status) "        \
+      "VALUES ($1, $2, $3, $4, $5) RETURNING id")                                               \
+    X(borrowing_update,                                                                         \
+      "UPDATE borrowing_records "                                                               \
+      "SET user_id = $1, book_id = $2, borrow_date = $3, due_date = $4, status = $5 "           \
+      "WHERE id = $6")                                                                          \
+    X(borrowing_return,                                                                         \
+      "UPDATE borrowing_records SET return_date = $1, status = $2 WHERE id = $3")               \
+    X(borrowing_renew,                                                                          \
+      "UPDATE borrowing_records "                                                               \
+      "SET due_date = due_date + INTERVAL '14 days', "                                          \
+      "status = " SQL_LITERAL(BORROWING_STATUS_RENEWED) " "                                     \
+      "WHERE id = $1 AND return_date IS NULL "                                                  \
+      "RETURNING due_date")                                                                     \
+    X(borrowing_active_loans_by_user,                                                           \
+      "SELECT r.id" BORROWING_COLUMNS(SQL_BORROWING_COLUMN) BOOK_COLUMNS(SQL_BOOK_COLUMN) " "   \
+      "FROM borrowing_records r JOIN books b ON b.id = r.book_id "                              \
+      "WHERE r.user_id = $1 AND r.return_date IS NULL ORDER BY r.due_date, r.id")               \
+    X(borrowing_borrow,                                                                         \
+      "SELECT refusal, (loan).id" BORROWING_COLUMNS(SQL_LOAN_COLUMN) " "                        \
+      "FROM borrow_book($1, $2, $3, $4, $5)")                                                   \
+    X(borrowing_return_active,                                                                  \
+      "SELECT " SQL_SELECT_LIST(BORROWING_COLUMNS) " FROM return_book($1, $2, $3)")             \
+                                                                                                \
+    /* users */                                                                                 \
+    X(user_find_by_id,                                                                          \
+      "SELECT " SQL_SELECT_LIST(USER_COLUMNS) " FROM users WHERE id = $1")                      \
+    X(user_identity_by_id,                                                                      \
+      "SELECT id, username, role FROM users WHERE id = $1")                                     \
+    X(user_find_by_username,                                                                    \
+      "SELECT " SQL_SELECT_LIST(USER_COLUMNS) " FROM users WHERE username = $1")                \
+    X(user_find_all,                                                                            \
+      "SELECT " SQL_SELECT_LIST(USER_COLUMNS) " FROM users")                                    \
+    X(user_conflict,                                                                            \
+      "SELECT id FROM users WHERE username = $1 OR email = $2")                                 \
+    X(user_update_conflict,                                                                     \
+      "SELECT id FROM users WHERE (username = $1 OR email = $2) AND id != $3")                  \
+    X(user_insert,                                                                              \
+      "INSERT INTO users (username, email, password_hash, role) "                               \
+      "VALUES ($1, $2, $3, $4) RETURNING id")                                                   \
+    X(user_update,                                                                              \
+      "UPDATE users SET username = $1, email = $2, password_hash = $3, role = $4 "              \
+      "WHERE id = $5")                                                                          \
+    X(user_has_active_borrowings,                                                               \
+      "SELECT id FROM borrowing_records WHERE user_id = $1 AND return_date IS NULL")            \
+    X(user_delete,                                                                              \
+      "DELETE FROM users WHERE id = $1")
+
+/*
+Queries walked through server-side cursors (utils/cursor_scan.hpp) or
+exported over COPY (utils/export_writer.hpp). Neither DECLARE nor COPY
+can run a prepared statement, so these stay plain SQL text.
+*/
+#define BOOK_SCAN_SQL                                                                           \
+    "SELECT " SQL_SELECT_LIST(BOOK_COLUMNS) " FROM books ORDER BY id"
+#define BORROWING_SCAN_SQL                                                                      \
+    "SELECT " SQL_SELECT_LIST(BORROWING_COLUMNS) " FROM borrowing_records WHERE TRUE"
+
+/*
+Bulk import (models/book_import.hpp): rows are COPYed into a per-transaction
+staging table, then merged into books in one statement. The staging table
+does not exist when connections prepare the catalog, so these stay plain SQL.
+*/
+#define BOOK_IMPORT_CREATE_SQL                                                                  \
+    "CREATE TEMP TABLE book_import ("                                                           \
+    "    isbn VARCHAR(13) NOT NULL, "                                                           \
+    "    title VARCHAR(255) NOT NULL, "                                                         \
+    "    author VARCHAR(100) NOT NULL, "                                                        \
+    "    publisher VARCHAR(100), "                                                              \
+    "    publish_date DATE, "                                                                   \
+    "    category VARCHAR(50), "                                                                \
+    "    total_copies INT NOT NULL"                                                             \
+    ") ON COMMIT DROP"
+
+/* Copies already on loan stay on loan when total_copies changes */
+#define BOOK_IMPORT_MERGE_SQL                                                                   \
+    "WITH merged AS ("                                                                          \
+    "    INSERT INTO books (isbn, title, author, publisher, publish_date, "                     \
+    "                       category, total_copies, available_copies) "                         \
+    "    SELECT isbn, title, author, publisher, publish_date, "                                 \
+    "           category, total_copies, total_copies "                                          \
+    "    FROM book_import "                                                                     \
+    "    ON CONFLICT (isbn) DO UPDATE SET "                                                     \
+    "        title = EXCLUDED.title, "                                                          \
+    "        author = EXCLUDED.author, "                                                        \
+    "        publisher = EXCLUDED.publisher, "                                                  \
+    "        publish_date = EXCLUDED.publish_date, "                                            \
+    "        category = EXCLUDED.category, "                                                    \
+    "        available_copies = GREATEST(books.available_copies "                               \
+    "            + EXCLUDED.total_copies - books.total_copies, 0), "                            \
+    "        total_copies = EXCLUDED.total_copies "                                             \
+    "    RETURNING (xmax = 0) AS inserted"                                                      \
+    ") "                                                                                        \
+    "SELECT COUNT(*) FILTER (WHERE inserted), COUNT(*) FILTER (WHERE NOT inserted) "            \
+    "FROM merged"
+
+/*
+The merge fires the books triggers once per row. Within the import transaction
+the flag below makes notify_cache_invalidation() skip them; one "books:*"
+notification (DB_NOTIFY_CHANNEL is $1) replaces them all at commit.
+*/
+#define BOOK_IMPORT_QUIET_SQL                                                                   \
+    "SET LOCAL library.bulk_import = 'on'"
+#define BOOK_IMPORT_NOTIFY_SQL                                                                  \
+    "SELECT pg_notify($1, 'books:*')"
+
+/*
+Statement names, e.g. Stmt::book_find_by_id
+*/
+struct Stmt {
+#define LIBRARY_STATEMENT_NAME(name, sql) static constexpr const char* name = #name;
+    LIBRARY_STATEMENTS(LIBRARY_STATEMENT_NAME)
+#undef LIBRARY_STATEMENT_NAME
+};
+
+/*
+Call fn(name, sql) for every statement in the catalog
+*/
+template <typename Fn>
+void forEachStatement(Fn&& fn) {
+#define LIBRARY_STATEMENT_VISIT(name, sql) fn(#name, sql);
+    LIBRARY_STATEMENTS(LIBRARY_STATEMENT_VISIT)
+#undef LIBRARY_STATEMENT_VISIT
+}
+
+/*
+Prepare the whole catalog on a freshly opened connection
+*/
+inline void prepareStatements(pqxx::connection& conn) {
+    forEachStatement([&conn](const char* name, const char* sql) { conn.prepare(name, sql); });
+}
@@ -0,0 +1,114 @@
+// include/utils/timestamp.hpp
+
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Whole-second UTC instant, used for every timestamptz column the models hold
+using Timestamp = std::chrono::sys_seconds;
+
+/*
+Parse PostgreSQL timestamptz output or an ISO 8601 string:
+    YYYY-MM-DD[( |T)HH:MM[:SS[.ffffff]]][Z|(+|-)HH[[:]MM[[:]SS]]]
+A missing offset means UTC, fractional seconds are dropped.
+*/
+inline std::optional<Timestamp> parseTimestamp(std::string_view text) {
+    using namespace std::chrono;
+
+    std::size_t pos = 0;
+    auto number = [&text, &pos](std::size_t digits, int& out) {
+        if (pos + digits > text.size()) {
+            return false;
+        }
+        out = 0;
+        for (std::size_t i = 0; i < digits; i++, pos++) {
+            char c = text[pos];
+            if (c < '0' || c > '9') {
+                return false;
+            }
+            out = out * 10 + (c - '0');
+        }
+        return true;
+    };
+    auto accept = [&text, &pos](char c) {
+        if (pos < text.size() && text[pos] == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    };
+
+    int y = 0, mo = 0, d = 0, h = 0, mi = 0, s = 0;
+    if (!number(4, y) || !accept('-') || !number(2, mo) || !accept('-') || !number(2, d)) {
+        return std::nullopt;
+    }
+    year_month_day date{year{y}, month{static_cast<unsigned>(mo)}, day{static_cast<unsigned>(d)}};
+    if (!date.ok()) {
+        return std::nullopt;
+    }
+
+    if (accept(' ') || accept('T')) {
+        if (!number(2, h) || !accept(':') || !number(2, mi)) {
+            return std::nullopt;
+        }
+        if (accept(':') && !number(2, s)) {
+            return std::nullopt;
+        }
+        if (accept('.')) {
+            while (pos < text.size() && text[pos] >= '0' && text[pos] <= '9') {
+                pos++;
+            }
+        }
+    }
+    if (h > 23 || mi > 59 || s > 60) {
+        return std::nullopt;
+    }
+
+    seconds offset{0};
+    if (!accept('Z') && pos < text.size() && (text[pos] == '+' || text[pos] == '-')) {
+        int sign = text[pos++] == '-' ? -1 : 1;
+        int oh = 0, om = 0, os = 0;
+        if (!number(2, oh)) {
+            return std::nullopt;
+        }
+        accept(':');
+        if (pos < text.size() && !number(2, om)) {
+            return std::nullopt;
+        }
+        accept(':');
+        if (pos < text.size() && !number(2, os)) {
+            return std::nullopt;
+        }
+        offset = sign * (hours{oh} + minutes{om} + seconds{os});
+    }
+    if (pos != text.size()) {
+        return std::nullopt;
+    }
+
+    // local time = UTC + offset
+    return sys_days{date} + hours{h} + minutes{mi} + seconds{s} - offset;
+}
+
+/*
+ISO 8601 in UTC, e.g. 2024-03-01T09:30:00Z; the only place timestamps become text
+*/
+inline std::string formatTimestamp(Timestamp timestamp) {
+    using namespace std::chrono;
+
+    auto day_start = floor<days>(timestamp);
+    year_month_day date{day_start};
+    hh_mm_ss time{timestamp - day_start};
+
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02uT%02d:%02d:%02dZ",
+                  static_cast<int>(date.year()),
+                  static_cast<unsigned>(date.month()),
+                  static_cast<unsigned>(date.day()),
+                  static_cast<int>(time.hours().count()),
+                  static_cast<int>(time.minutes().count()),
+                  static_cast<int>(time.seconds().count()));
+    return buffer;
+}
@@ -1,40 +1,77 @@
 // src/controllers/book_controller.cpp
 
 #include "controllers/book_controller.hpp"
+#include "controllers/borrowing_controller.hpp"
+#include "models/book_cache.hpp"
+#include "utils/database_pool.hpp"
 #include "models/book.hpp"
+#include <chrono>
 #include <exception>
 #include <string>
 
+// 列表行转 JSON, 直接读取结果集中的视图, 不做逐行拷贝
+static nlohmann::json bookRowToJson(const BookRow& book){
+    return {
+        {"id", book.id},
+        {"isbn", book.isbn},
+        {"title", book.title},
+        {"author", book.author},
+        {"publisher", book.publisher},
+        {"publishDate", book.publish_date},
+        {"category", book.category},
+        {"totalCopies", book.total_copies},
+        {"availableCopies", book.available_copies}
+    };
+}
+
+static nlohmann::json loanRowToJson(const LoanRow& loan, Timestamp now){
+    return {
+        {"recordId", loan.id},
+        {"borrowDate", formatTimestamp(loan.borrow_date)},
+        {"dueDate", formatTimestamp(loan.due_date)},
+        {"status", borrowingStatusName(loan.status)},
+        {"overdue", loan.due_date < now},
+        {"book", {
+            {"id", loan.book_id},
+            {"isbn", loan.isbn},
+            {"title", loan.title},
+            {"author", loan.author},
+            {"publisher", loan.publisher},
+            {"publishDate", loan.publish_date},
+            {"category", loan.category},
+            {"totalCopies", loan.total_copies},
+            {"availableCopies", loan.available_copies}
+        }}
+    };
+}
+
 nlohmann::json BookController::handleGetAllBooks(
-    const std::string& page,
+    const std::string& cursor,
     const std::string& pageSize
 ){
     try {
-            int page_ = std::stoi(page);
-            int pageSize_ = std::stoi(pageSize);
-            auto books = bookService_.getAllBooks(page_, pageSize_);
-            int total = bookService_.getTotalBooks();
+            int pageSize_ = pageSize.empty() ? PAGESIZE : std::stoi(pageSize);
+            auto page = bookService_.getAllBooks(cursor, pageSize_);
 
             nlohmann::json response = {
                 {"success", true},
-                {"total", total},
-                {"page", page_},
                 {"pageSize", pageSize_},
-                {"books", nlohmann::json::array()}
+                {"books", nlohmann::json::array()},
+                {"nextCursor", nullptr}
             };
 
-            for (const auto& book : books) {
-            response["books"].push_back({
-                {"id", book->getId()},
-                {"isbn", book->getIsbn()},
-                {"title", book->getTitle()},
-                {"author", book->getAuthor()},
-                {"publisher", book->getPublisher()},
-                {"publishDate", book->getPublishDate()},
-                {"category", book->getCategory()},
-                {"totalCopies", book->getTotalCopies()},
-                {"availableCopies", book->getAvailableCopies()}
-            });}
+            // 总数只在第一页返回, 翻页不再重复统计
+            if (cursor.empty()) {
+                response["total"] = bookService_.getTotalBooks();
+            }
+
+            for (const auto& book : page.books) {
+                response["books"].push_back(bookRowToJson(book));
+            }
+
+            if (!page.next_cursor.empty()) {
+                response["nextCursor"] = page.next_cursor;
+            }
 
             return response;
 
@@ -47,6 +84,133 @@ nlohmann::json BookController::handleGetAllBooks(
     }
 }
 
+nlohmann::json BookController::handleSearchBook(const std::string& keyword){
+    try {
+        auto books = bookService_.SearchBooks(keyword);
+
+        nlohmann::json response = {
+            {"success", true},
+            {"books", nlohmann::json::array()}
+        };
+
+        for (const auto& book : books) {
+            response["books"].push_back(bookRowToJson(book));
+        }
+
+        return response;
+    } catch (const std::exception& e) {
+        return {
+            {"success", false},
+            {"error", e.what()}
+        };
+    }
+}
+
+nlohmann::json BookController::handleGetBorrowedBooks(const std::string& user_id){
+    try {
+        auto loans = bookService_.getBorrowedBooks(std::stoi(user_id));
+        auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+
+        nlohmann::json response = {
+            {"success", true},
+            {"loans", nlohmann::json::array()}
+        };
+
+        for (const auto& loan : loans) {
+            response["loans"].push_back(loanRowToJson(loan, now));
+        }
+
+        return response;
+    } catch (const std::exception& e) {
+        return {
+            {"success", false},
+            {"error", e.what()}
+        };
+    }
+}
+
+nlohmann::json BookController::handleGetCatalogStats(){
+    try {
+        auto counters = bookService_.getCatalogCounters();
+
+        nlohmann::json categories = nlohmann::json::array();
+        for (const auto& category : counters.categories) {
+            categories.push_back({
+                {"category", category.category},
+                {"books", category.books},
+                {"totalCopies", category.total_copies},
+                {"availableCopies", category.available_copies}
+            });
+        }
+
+        return {
+            {"success", true},
+            {"books", counters.books},
+            {"totalCopies", counters.total_copies},
+            {"availableCopies", counters.available_copies},
+            {"categories", categories}
+        };
+    } catch (const std::exception& e) {
+        return {
+            {"success", false},
+            {"error", e.what()}
+        };
+    }
+}
+
+SerializedResponse BookController::cachedResponse(
+    const std::string& key,
+    const std::string& if_none_match,
+    const std::function<nlohmann::json()>& build
+){
+    // 版本在生成响应之前读取: 生成期间目录若有变化, 存入的条目已经过期, 下次即失效
+    auto version = BookCache::getInstance().catalogVersion();
+    if (auto cached = responseCache_.get(key, version, if_none_match)) {
+        return std::move(*cached);
+    }
+
+    /*
+    目录版本只在主库的写入提交后推进, 所以要缓存的响应从主库生成.
+    若从落后的副本读取, 按新版本存入的会是旧数据, 并且一直留到下一次无关的写入.
+    只有未命中时才访问主库, 命中的请求不访问数据库
+    */
+    nlohmann::json response;
+    {
+        DatabasePool::PrimaryReadScope primary_reads;
+        response = build();
+    }
+    std::string body = response.dump();
+    if (!response.value("success", false)) {
+        // 错误响应不缓存
+        SerializedResponse error;
+        error.body = std::make_shared<const std::string>(std::move(body));
+        return error;
+    }
+    return std::move(*responseCache_.put(key, version, std::move(body), if_none_match));
+}
+
+SerializedResponse BookController::handleGetAllBooksCached(
+    const std::string& cursor,
+    const std::string& pageSize,
+    const std::string& if_none_match
+){
+    // \x1f 分隔各参数, 不会与参数内容混淆
+    std::string key = "books\x1f" + cursor + "\x1f" + pageSize;
+    return cachedResponse(key, if_none_match, [this, &cursor, &pageSize]() {
+        return handleGetAllBooks(cursor, pageSize);
+    });
+}
+
+SerializedResponse BookController::handleSearchBookCached(
+    const std::string& keyword,
+    const std::string& if_none_match
+){
+    std::string key = "search\x1f" + keyword;
+    return cachedResponse(key, if_none_match, [this, &keyword]() {
+        return handleSearchBook(keyword);
+    });
+}
+
 nlohmann::json BookController::handleAddBook(const nlohmann::json& book_data) {
     try {
         auto book = bookService_.addBook(
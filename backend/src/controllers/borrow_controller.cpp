@@ -1,6 +1,43 @@
 // src/controllers/borrow_controller.cpp
 
 #include "controllers/borrowing_controller.hpp"
+#include <optional>
+#include <stdexcept>
+
+// 请求中的日期在这里解析, 之后只以 Timestamp 传递; 缺省字段返回 nullopt
+static std::optional<Timestamp> requestTimestamp(const nlohmann::json& request, const char* key){
+    if (!request.contains(key) || request[key].is_null()) {
+        return std::nullopt;
+    }
+    std::string text = request[key];
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    auto timestamp = parseTimestamp(text);
+    if (!timestamp) {
+        throw std::invalid_argument(std::string("invalid ") + key);
+    }
+    return timestamp;
+}
+
+static const char* borrowRefusalMessage(BorrowRefusal refusal){
+    switch (refusal) {
+        case BorrowRefusal::USER_NOT_FOUND:       return "User not found";
+        case BorrowRefusal::BOOK_NOT_FOUND:       return "Book not found";
+        case BorrowRefusal::NO_COPIES_AVAILABLE:  return "No copies available";
+        case BorrowRefusal::BORROW_LIMIT_REACHED: return "Borrow limit reached";
+        case BorrowRefusal::HAS_OVERDUE:          return "User has overdue books";
+        case BorrowRefusal::ALREADY_BORROWED:     return "Book already borrowed by this user";
+        default:                                  return "Failed to borrow book";
+    }
+}
+
+static nlohmann::json timestampToJson(const std::optional<Timestamp>& timestamp){
+    if (!timestamp) {
+        return nullptr;
+    }
+    return formatTimestamp(*timestamp);
+}
 
 nlohmann::json BorrowingController::handleBorrowBook(const nlohmann::json& request){
     try{
@@ -11,16 +48,16 @@ nlohmann::json BorrowingController::handleBorrowBook(const nlohmann::json& reque
         int user_id = request["user_id"];
         int book_id = request["book_id"];
 
-        std::string borrow_date = request.contains("borrow_date") ? request["borrow_date"] : "";
-        std::string due_date = request.contains("due_date") ? request["due_date"] : "";
+        auto borrow_date = requestTimestamp(request, "borrow_date");
+        auto due_date = requestTimestamp(request, "due_date");
 
-        auto record = borrowingService_.borrowBook(user_id, book_id, borrow_date, due_date);
+        auto result = borrowingService_.borrowBook(user_id, book_id, borrow_date, due_date);
 
-        if (record == nullptr) {
-            return createErrorResponse("Failed to borrow book");
+        if (result.record == nullptr) {
+            return createErrorResponse(borrowRefusalMessage(result.refusal));
         }
 
-        return createSuccessResponse("Book borrowed successfully", borrowingRecordToJson(record.get()));
+        return createSuccessResponse("Book borrowed successfully", borrowingRecordToJson(result.record.get()));
         } catch (const std::exception& e) {
             return createErrorResponse(std::string("Error while borrowing_book: ")+e.what());
         }
@@ -35,7 +72,7 @@ nlohmann::json BorrowingController::handleReturnBook(const nlohmann::json& reque
 
         int user_id = request["user_id"];
         int book_id = request["book_id"];
-        std::string return_date = request.contains("return_date") ? request["return_date"] : "";
+        auto return_date = requestTimestamp(request, "return_date");
         if(!borrowingService_.returnBook(user_id, book_id, return_date)){
             return createErrorResponse("Failed to return book");
         }
@@ -118,7 +155,7 @@ nlohmann::json BorrowingController::handleGetOverdueBooks(){
         };
 
         for (const auto& record : records) {
-            response["borrowings"].push_back(borrowingRecordToJson(record.get()));
+            response["borrowings"].push_back(borrowingRowToJson(record));
         }
 
         return response;
@@ -134,12 +171,16 @@ nlohmann::json BorrowingController::handleGetUserBorrowStatus(const std::string&
     {
         int user_id_int = std::stoi(user_id);
 
-        int current_borrowed = borrowingService_.getUserCurrentBorrowCount(user_id_int);
-        int overdue_count = borrowingService_.getUserOverdueCount(user_id_int);
+        // 两个计数由同一条分组查询返回
+        auto statuses = borrowingService_.getUserBorrowStatuses({user_id_int});
+        auto found = statuses.find(user_id_int);
+        if (found == statuses.end()) {
+            return createErrorResponse("Failed to get user borrow status");
+        }
 
         nlohmann::json status = {
-            {"current_borrowed", current_borrowed},
-            {"overdue_count", overdue_count}
+            {"current_borrowed", found->second.active_count},
+            {"overdue_count", found->second.overdue_count}
         };
         return createSuccessResponse("User borrow status retrieved successfully", status);
     }
@@ -150,27 +191,76 @@ nlohmann::json BorrowingController::handleGetUserBorrowStatus(const std::string&
 
 }
 
-nlohmann::json createSuccessResponse(const std::string& message, const nlohmann::json& data = nullptr){
-nlohmann::json response = {
-    {"success", true},
-    {"message", message}
-};
+nlohmann::json BorrowingController::handleGetUserBorrowStatuses(const nlohmann::json& request){
+    try
+    {
+        if (!request.contains("user_ids") || !request["user_ids"].is_array()) {
+            return createErrorResponse("Missing required fields");
+        }
+        if (request["user_ids"].size() > MAX_STATUS_BATCH) {
+            return createErrorResponse("Too many user ids, at most " + std::to_string(MAX_STATUS_BATCH));
+        }
 
-if (data != nullptr) {
-    response["data"] = data;
+        std::vector<int> user_ids;
+        user_ids.reserve(request["user_ids"].size());
+        for (const auto& id : request["user_ids"]) {
+            user_ids.push_back(id.get<int>());
+        }
+
+        auto statuses = borrowingService_.getUserBorrowStatuses(user_ids);
+        if (statuses.empty() && !user_ids.empty()) {
+            return createErrorResponse("Failed to get user borrow status");
+        }
+
+        // 按请求中的顺序返回
+        nlohmann::json data = nlohmann::json::array();
+        for (int user_id : user_ids) {
+            const auto& status = statuses[user_id];
+            data.push_back({
+                {"user_id", user_id},
+                {"current_borrowed", status.active_count},
+                {"overdue_count", status.overdue_count}
+            });
+        }
+        return createSuccessResponse("User borrow statuses retrieved successfully", data);
+    }
+    catch(const std::exception& e)
+    {
+        return createErrorResponse(std::string("Error while getting user borrow statuses: ") + e.what());
+    }
 }
 
-return response;
+nlohmann::json BorrowingController::createSuccessResponse(const std::string& message, const nlohmann::json& data){
+    nlohmann::json response = {
+        {"success", true},
+        {"message", message}
+    };
+
+    if (data != nullptr) {
+        response["data"] = data;
+    }
+
+    return response;
 }
 
-nlohmann::json createErrorResponse(const std::string& message){
+nlohmann::json BorrowingController::createErrorResponse(const std::string& message){
     return {
         {"success", false},
         {"error", message}
     };
 }
 
-nlohmann::json borrowingRecordToJson(const BorrowingRecord* record){
+const char* borrowingStatusName(BorrowingRecord::Status status){
+    switch (status) {
+        case BorrowingRecord::Status::BORROWED: return "borrowed";
+        case BorrowingRecord::Status::RETURNED: return "returned";
+        case BorrowingRecord::Status::OVERDUE: return "overdue";
+        case BorrowingRecord::Status::RENEWED: return "renewed";
+    }
+    return "unknown";
+}
+
+nlohmann::json BorrowingController::borrowingRecordToJson(const BorrowingRecord* record){
     if (record == nullptr) {
         return nullptr;
     }
@@ -179,9 +269,22 @@ nlohmann::json borrowingRecordToJson(const BorrowingRecord* record){
         {"id", record->getId()},
         {"user_id", record->getUserId()},
         {"book_id", record->getBookId()},
-        {"borrow_date", record->getBorrowDate()},
-        {"due_date", record->getDueDate()},
-        {"return_date", record->getReturnDate()},
-        {"status", record->getStatus()}
+        {"borrow_date", formatTimestamp(record->getBorrowDate())},
+        {"due_date", formatTimestamp(record->getDueDate())},
+        {"return_date", timestampToJson(record->getReturnDate())},
+        {"status", borrowingStatusName(record->getStatus())},
+        {"overdue", record->isOverdue()}
+    };
+}
+
+nlohmann::json BorrowingController::borrowingRowToJson(const BorrowingRow& record){
+    return {
+        {"id", record.id},
+        {"user_id", record.user_id},
+        {"book_id", record.book_id},
+        {"borrow_date", formatTimestamp(record.borrow_date)},
+        {"due_date", formatTimestamp(record.due_date)},
+        {"return_date", timestampToJson(record.return_date)},
+        {"status", borrowingStatusName(record.status)}
     };
 }
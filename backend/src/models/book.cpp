@@ -1,21 +1,100 @@
 // src/models/book.cpp
 
 #include "models/book.hpp"
+#include "models/book_cache.hpp"
+#include "utils/async_query.hpp"
+#include "utils/cursor_scan.hpp"
 #include "utils/database_pool.hpp"
+#include "utils/row_mapper.hpp"
+#include "utils/statements.hpp"
+#include <cstdint>
 #include <iostream>
 #include <exception>
+#include <future>
 #include <vector>
 
+// 成员顺序与 SQL_SELECT_LIST(BOOK_COLUMNS) 一致, 按列下标绑定
+#define BOOK_MEMBER(column) , &Book::column##_
+template <>
+struct ModelTraits<Book> {
+    static constexpr auto members = std::make_tuple(&Book::id_ BOOK_COLUMNS(BOOK_MEMBER));
+};
+#undef BOOK_MEMBER
+
+std::unique_ptr<Book> Book::fromRow(const pqxx::row& row)
+{
+    return RowMapper<Book>::map(row);
+}
+
+static std::unique_ptr<Book> firstBook(const AsyncResult& result)
+{
+    if (result.empty()) {
+        return nullptr;
+    }
+    return RowMapper<Book>::parse([&result](int col) { return result.get(0, col); });
+}
+
+static std::future<std::unique_ptr<Book>> readyBook(std::unique_ptr<Book> book)
+{
+    std::promise<std::unique_ptr<Book>> promise;
+    promise.set_value(std::move(book));
+    return promise.get_future();
+}
+
+// 转换结果的同时回填缓存
+static auto firstBookCached(std::uint64_t generation)
+{
+    return [generation](const AsyncResult& result) {
+        auto book = firstBook(result);
+        if (book != nullptr) {
+            BookCache::getInstance().put(*book, generation);
+        }
+        return book;
+    };
+}
+
+std::future<std::unique_ptr<Book>> Book::findByIdAsync(int book_id)
+{
+    auto& cache = BookCache::getInstance();
+    if (auto cached = cache.findById(book_id)) {
+        return readyBook(std::move(cached));
+    }
+
+    return AsyncExecutor::getInstance().execPrepared<std::unique_ptr<Book>>(
+        Stmt::book_find_by_id,
+        {std::to_string(book_id)},
+        firstBookCached(cache.generation()));
+}
+
+std::future<std::unique_ptr<Book>> Book::findByIsbnAsync(const std::string& isbn)
+{
+    auto& cache = BookCache::getInstance();
+    if (auto cached = cache.findByIsbn(isbn)) {
+        return readyBook(std::move(cached));
+    }
+
+    return AsyncExecutor::getInstance().execPrepared<std::unique_ptr<Book>>(
+        Stmt::book_find_by_isbn,
+        {isbn},
+        firstBookCached(cache.generation()));
+}
 
 std::unique_ptr<Book> Book::findById(int book_id)
 {
-    auto conn = DatabasePool::getInstance().getConnection();
+    auto& cache = BookCache::getInstance();
+    if (auto cached = cache.findById(book_id)) {
+        return cached;
+    }
+    auto generation = cache.generation();
+
+    static const PoolSite site("Book::findById");
+    auto conn = DatabasePool::getInstance().getConnection(site);
     try
     {
-        pqxx::work txn(*conn);
+        pqxx::nontransaction txn(*conn);
 
-        auto result = txn.exec_params(
-                "SELECT * FROM books WHERE id = $1",
+        auto result = txn.exec_prepared(
+                Stmt::book_find_by_id,
                 book_id
             );
 
@@ -23,21 +102,8 @@ std::unique_ptr<Book> Book::findById(int book_id)
             return nullptr;
         }
 
-        const auto& row = result[0];
-        auto book = Book::create()
-            .setIsbn(row["isbn"].as<std::string>())
-            .setTitle(row["title"].as<std::string>())
-            .setAuthor(row["author"].as<std::string>())
-            .setPublisher(row["publisher"].as<std::string>())
-            .setPublishDate(row["publish_date"].as<std::string>())
-            .setCategory(row["category"].as<std::string>())
-            .setTotalCopies(row["total_copies"].as<int>())
-            .build();
-
-        book->id_ = row["id"].as<int>();
-        book->available_copies_ = row["available_copies"].as<int>();
-
-        txn.commit();
+        auto book = RowMapper<Book>::map(result[0]);
+        cache.put(*book, generation);
         return book;
     }
     catch (const std::exception &e)
@@ -48,13 +114,20 @@ std::unique_ptr<Book> Book::findById(int book_id)
     }
 }
 std::unique_ptr<Book> Book::findByIsbn(const std::string &isbn){
-    auto conn = DatabasePool::getInstance().getConnection();
+    auto& cache = BookCache::getInstance();
+    if (auto cached = cache.findByIsbn(isbn)) {
+        return cached;
+    }
+    auto generation = cache.generation();
+
+    static const PoolSite site("Book::findByIsbn");
+    auto conn = DatabasePool::getInstance().getConnection(site);
     try
     {
-        pqxx::work txn(*conn);
+        pqxx::nontransaction txn(*conn);
 
-        auto result = txn.exec_params(
-                "SELECT * FROM books WHERE isbn = $1",
+        auto result = txn.exec_prepared(
+                Stmt::book_find_by_isbn,
                 isbn
             );
 
@@ -62,138 +135,121 @@ std::unique_ptr<Book> Book::findByIsbn(const std::string &isbn){
             return nullptr;
         }
 
-        const auto& row = result[0];
-        auto book = Book::create()
-            .setIsbn(row["isbn"].as<std::string>())
-            .setTitle(row["title"].as<std::string>())
-            .setAuthor(row["author"].as<std::string>())
-            .setPublisher(row["publisher"].as<std::string>())
-            .setPublishDate(row["publish_date"].as<std::string>())
-            .setCategory(row["category"].as<std::string>())
-            .setTotalCopies(row["total_copies"].as<int>())
-            .build();
-
-        book->id_ = row["id"].as<int>();
-        book->available_copies_ = row["available_copies"].as<int>();
-
-        txn.commit();
+        auto book = RowMapper<Book>::map(result[0]);
+        cache.put(*book, generation);
         return book;
     }
     catch (const std::exception &e)
     {
-        std::cerr << "Error in findById(): "<< e.what() <<std::endl;
+        std::cerr << "Error in findByIsbn(): "<< e.what() <<std::endl;
         //TODO
         return nullptr;
     }
 
 }
-std::vector<std::unique_ptr<Book>> Book::search(const std::string& keyword){
-    std::vector<std::unique_ptr<Book>> books;
-    auto conn = DatabasePool::getInstance().getConnection();
+CatalogCounters Book::counters(){
+    CatalogCounters counters;
+    static const PoolSite site("Book::counters");
+    auto conn = DatabasePool::getInstance().getReadConnection(site);
 
     try {
-        pqxx::work txn(*conn);
+        pqxx::nontransaction txn(*conn);
+
+        auto result = txn.exec_prepared(Stmt::book_counters_by_category);
+
+        counters.categories.reserve(result.size());
+        for (const auto& row : result) {
+            CategoryCount category;
+            category.category = row[0].as<std::string>();
+            category.books = row[1].as<long>();
+            category.total_copies = row[2].as<long>();
+            category.available_copies = row[3].as<long>();
+
+            counters.books += category.books;
+            counters.total_copies += category.total_copies;
+            counters.available_copies += category.available_copies;
+            counters.categories.push_back(std::move(category));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error in Book::counters(): " << e.what() << std::endl;
+    }
+    return counters;
+}
+
+BookList Book::search(const std::string& keyword){
+    static const PoolSite site("Book::search");
+    auto conn = DatabasePool::getInstance().getReadConnection(site);
+
+    try {
+        pqxx::nontransaction txn(*conn);
 
-        auto res = txn.exec_params(
-            "SELECT * FROM books"
-            "WHERE title ILIKE $1"
-            "   OR author ILIKE $1"
-            "   OR isbn ILIKE $1"
-            "   OR publisher ILIKE $1"
-            "   OR category ILIKE $1"
-            "ORDER BY "
-            "   CASE "
-            "       WHEN title ILIKE $1 THEN 1 "  // 标题匹配优先
-            "       WHEN author ILIKE $1 THEN 2 "  // 作者匹配次之
-            "       WHEN isbn = $2 THEN 3 "        // ISBN精确匹配
-            "       ELSE 4 "
-            "   END, "
-            "   title ASC "
-            "LIMIT 100",  // 限制返回数量
+        auto res = txn.exec_prepared(
+            Stmt::book_search,
             "%" + keyword + "%",  // 用于模糊匹配的参数
             keyword               // 用于精确匹配的参数
         );
 
-         for (const auto& row : res) {
-            try {
-                auto book = Book::create()
-                    .setIsbn(row["isbn"].as<std::string>())
-                    .setTitle(row["title"].as<std::string>())
-                    .setAuthor(row["author"].as<std::string>())
-                    .setPublisher(row["publisher"].as<std::string>())
-                    .setPublishDate(row["publish_date"].as<std::string>())
-                    .setCategory(row["category"].as<std::string>())
-                    .setTotalCopies(row["total_copies"].as<int>())
-                    .build();
-
-                book->id_ = row["id"].as<int>();
-                book->available_copies_ = row["available_copies"].as<int>();
-                books.push_back(std::move(book));
-            } catch (const std::exception& e) {
-                // 如果单个图书对象创建失败，记录错误但继续处理其他结果
-                std::cerr << "Error creating book object: " << e.what() << std::endl;
-                continue;
-            }
-        }
-        return books;
+        return BookList::from(res);
     } catch (const std::exception& e) {
-        return books;
+        std::cerr << "Error in Book::search(): " << e.what() <<std::endl;
+        return {};
     }
 }
 
-std::vector<std::unique_ptr<Book>> Book::findAll(int page, int pagesize){
-    auto conn = DatabasePool::getInstance().getConnection();
-    std::vector<std::unique_ptr<Book>> books;
+BookList Book::findPage(const PageCursor& after, int limit){
+    static const PoolSite site("Book::findPage");
+    auto conn = DatabasePool::getInstance().getReadConnection(site);
     try {
-        pqxx::work txn(*conn);
-        auto result = txn.exec_params(
-                "SELECT *"
-                "FROM books "
-        );
+        pqxx::nontransaction txn(*conn);
 
-        if (result.empty()) {
-            return books;
-        }
+        // 键集分页: 从上一页最后一行之后继续, 不随页码增长扫描量
+        auto result = after.id == 0
+            ? txn.exec_prepared(Stmt::book_page_first, limit)
+            : txn.exec_prepared(Stmt::book_page_after, after.key, after.id, limit);
 
+        return BookList::from(result);
 
-        for(auto row : result){
-            auto book = Book::create()
-                .setIsbn(row["isbn"].as<std::string>())
-                .setTitle(row["title"].as<std::string>())
-                .setAuthor(row["author"].as<std::string>())
-                .setPublisher(row["publisher"].as<std::string>())
-                .setPublishDate(row["publish_date"].as<std::string>())
-                .setCategory(row["category"].as<std::string>())
-                .setTotalCopies(row["total_copies"].as<int>())
-                .build();
+    } catch (const std::exception& e) {
+       std::cerr << "Error in Book::findPage(): " << e.what() <<std::endl;
+        return {};
+    }
+}
 
-            book->id_ = row["id"].as<int>();
-            book->available_copies_ = row["available_copies"].as<int>();
+long Book::forEach(const std::function<bool(const BookList& batch)>& callback){
+    static const PoolSite site("Book::forEach");
+    CursorScan<BookRow> scan(BOOK_SCAN_SQL, site);
+    long rows = 0;
 
-            books.push_back(book);
+    while (scan.nextBatch()) {
+        rows += static_cast<long>(scan.batch().size());
+        if (!callback(scan.batch())) {
+            break;
         }
-       txn.commit();
-
-        return books;
+    }
+    return scan.failed() ? -1 : rows;
+}
 
+long Book::exportTo(std::ostream& out, ExportFormat format, ExportCompression compression){
+    static const PoolSite site("Book::exportTo");
+    try {
+        ExportWriter writer(out, format, compression, exportColumns<BookRow>({SQL_COLUMN_LABELS(BOOK_COLUMNS)}));
+        return exportQuery(BOOK_SCAN_SQL, site, writer);
     } catch (const std::exception& e) {
-       std::cerr << "Error in Book::findAll(): " << e.what() <<std::endl;
-        return books;
+        std::cerr << "Error in Book::exportTo(): " << e.what() << std::endl;
+        return -1;
     }
 }
 
-
-std::vector<std::unique_ptr<Book>> search(const std::string &keyword);
-
 bool Book::save() {
 
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("Book::save");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site);
     try {
         pqxx::work txn(*conn);
 
         // 检查ISBN是否已存在
-        auto check = txn.exec_params(
-            "SELECT id FROM books WHERE isbn = $1",
+        auto check = txn.exec_prepared(
+            Stmt::book_isbn_exists,
             isbn_
         );
 
@@ -201,10 +257,8 @@ bool Book::save() {
             return false; // ISBN已存在
         }
 
-        auto result = txn.exec_params(
-            "INSERT INTO books (isbn, title, author, publisher, publish_date, "
-            "category, total_copies, available_copies) "
-            "VALUES ($1, $2, $3, $4, $5, $6, $7, $8) RETURNING id",
+        auto result = txn.exec_prepared(
+            Stmt::book_insert,
             isbn_, title_, author_, publisher_, publish_date_,
             category_, total_copies_, available_copies_
         );
@@ -212,6 +266,7 @@ bool Book::save() {
         if (!result.empty()) {
             id_ = result[0]["id"].as<int>();
             txn.commit();
+            BookCache::getInstance().insert(*this);
             return true;
         }
         return false;
@@ -225,13 +280,14 @@ bool Book::update(){
         return false;
     }
 
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("Book::update");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site);
 
     try{
         pqxx::work txn(*conn);
 
-        auto check = txn.exec_params(
-            "SELECT id FROM books WHERE isbn = $1 AND id != $2",
+        auto check = txn.exec_prepared(
+            Stmt::book_isbn_conflict,
             isbn_, id_
         );
 
@@ -239,15 +295,14 @@ bool Book::update(){
             return false;
         }
 
-        auto result = txn.exec_params(
-            "UPDATE books SET isbn = $1, title = $2, author = $3,"
-            "publisher = $4, publish_date = $5, categroy = $6, "
-            "total_copies = $7, available_copies = $8 WHERE id = $9",
+        auto result = txn.exec_prepared(
+            Stmt::book_update,
             isbn_, title_, author_, publisher_, publish_date_,
             category_, total_copies_, available_copies_, id_
         );
 
         txn.commit();
+        BookCache::getInstance().invalidate(id_);
 
         return result.affected_rows() > 0;
 
@@ -261,14 +316,14 @@ bool Book::remove(){
         return false;
     }
 
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("Book::remove");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site);
     try {
         pqxx::work txn(*conn);
 
         // 检查是否有未归还的借阅记录
-        auto check = txn.exec_params(
-            "SELECT id FROM borrowing_records "
-            "WHERE book_id = $1 AND return_date IS NULL",
+        auto check = txn.exec_prepared(
+            Stmt::book_has_active_borrowings,
             id_
         );
 
@@ -276,12 +331,13 @@ bool Book::remove(){
             return false; // 有未归还的记录，不能删除
         }
 
-        auto result = txn.exec_params(
-            "DELETE FROM books WHERE id = $1",
+        auto result = txn.exec_prepared(
+            Stmt::book_delete,
             id_
         );
 
         txn.commit();
+        BookCache::getInstance().invalidate(id_);
         return result.affected_rows() > 0;
     } catch (const std::exception& e) {
         std::cerr << "Error in remove(): " << e.what() << std::endl;
@@ -294,18 +350,26 @@ bool Book::borrow(){
         return false;
     }
 
-     auto conn = DatabasePool::getInstance().getConnection();
+     static const PoolSite site("Book::borrow");
+     auto conn = DatabasePool::getInstance().getWriteConnection(site);
     try {
         pqxx::work txn(*conn);
 
-        available_copies_--;
-        auto result = txn.exec_params(
-            "UPDATE books SET available_copies = $1 WHERE id = $2",
-            available_copies_, id_
+        // 在数据库端按条件增减, 并发借还不会丢失更新
+        auto result = txn.exec_prepared(
+            Stmt::book_take_copy,
+            id_
         );
 
+        if (result.empty()) {
+            return false;
+        }
+
+        available_copies_ = result[0][0].as<int>();
         txn.commit();
-        return result.affected_rows() > 0;
+        // 不写入 available_copies_: 并发借还的提交顺序未知, 写入的可能已是旧值
+        BookCache::getInstance().invalidateAvailability(id_);
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "Error in borrow(): " << e.what() << std::endl;
         return false;
@@ -317,18 +381,26 @@ bool Book::return_book(){
         return false;
     }
 
-     auto conn = DatabasePool::getInstance().getConnection();
+     static const PoolSite site("Book::return_book");
+     auto conn = DatabasePool::getInstance().getWriteConnection(site);
     try {
         pqxx::work txn(*conn);
 
-        available_copies_++;
-        auto result = txn.exec_params(
-            "UPDATE books SET available_copies = $1 WHERE id = $2",
-            available_copies_, id_
+        // 在数据库端按条件增减, 并发借还不会丢失更新
+        auto result = txn.exec_prepared(
+            Stmt::book_return_copy,
+            id_
         );
 
+        if (result.empty()) {
+            return false;
+        }
+
+        available_copies_ = result[0][0].as<int>();
         txn.commit();
-        return result.affected_rows() > 0;
+        // 不写入 available_copies_: 并发借还的提交顺序未知, 写入的可能已是旧值
+        BookCache::getInstance().invalidateAvailability(id_);
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "Error in return_book(): " << e.what() << std::endl;
         return false;
@@ -0,0 +1,171 @@
+// src/models/book_cache.cpp
+
+#include "models/book_cache.hpp"
+#include "utils/invalidation_listener.hpp"
+
+BookCache::BookCache()
+    : metadata_(BOOK_CACHE_CAPACITY, BOOK_CACHE_SHARDS),
+      availability_(BOOK_CACHE_CAPACITY, BOOK_CACHE_SHARDS),
+      isbn_index_(BOOK_CACHE_CAPACITY, BOOK_CACHE_SHARDS)
+{
+    auto& listener = InvalidationListener::getInstance();
+    auto reset = [this]() { clear(); };
+
+    subscriptions_.push_back(listener.subscribe("books", [this](const std::vector<int>& ids) {
+        for (int book_id : ids) {
+            invalidate(book_id);
+        }
+    }, reset));
+
+    // 只有库存变化的 books 更新 (借还) 单独通知, 元数据保留
+    subscriptions_.push_back(listener.subscribe("book_availability", [this](const std::vector<int>& ids) {
+        for (int book_id : ids) {
+            invalidateAvailability(book_id);
+        }
+    }, nullptr));
+
+    // 借还记录变化时通知的是 book_id, 只影响库存
+    subscriptions_.push_back(listener.subscribe("borrowing_records", [this](const std::vector<int>& ids) {
+        for (int book_id : ids) {
+            invalidateAvailability(book_id);
+        }
+    }, nullptr));
+}
+
+BookCache::~BookCache()
+{
+    auto& listener = InvalidationListener::getInstance();
+    for (int subscription : subscriptions_) {
+        listener.unsubscribe(subscription);
+    }
+}
+
+std::unique_ptr<Book> BookCache::findById(int book_id)
+{
+    auto metadata = metadata_.get(book_id);
+    if (!metadata) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    auto available = availability_.get(book_id);
+    if (!available) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+
+    const Metadata& cached = **metadata;
+    std::unique_ptr<Book> book(new Book());
+    book->id_ = cached.id;
+    book->isbn_ = cached.isbn;
+    book->title_ = cached.title;
+    book->author_ = cached.author;
+    book->publisher_ = cached.publisher;
+    book->publish_date_ = cached.publish_date;
+    book->category_ = cached.category;
+    book->total_copies_ = cached.total_copies;
+    book->available_copies_ = *available;
+    return book;
+}
+
+std::unique_ptr<Book> BookCache::findByIsbn(const std::string& isbn)
+{
+    auto book_id = isbn_index_.get(isbn);
+    if (!book_id) {
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    auto book = findById(*book_id);
+    // 索引条目可能比元数据旧 (ISBN 已被改到别的书上)
+    if (book != nullptr && book->getIsbn() != isbn) {
+        isbn_index_.erase(isbn);
+        return nullptr;
+    }
+    return book;
+}
+
+std::uint64_t BookCache::mark(int book_id)
+{
+    auto sequence = sequence_.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+    // 并发标记同一个槽时只能增大, 否则较早的序号会覆盖较晚的
+    auto& slot = invalidated_at_[stripe(book_id)];
+    auto current = slot.load(std::memory_order_acquire);
+    while (current < sequence && !slot.compare_exchange_weak(current, sequence, std::memory_order_acq_rel)) {
+    }
+    return sequence;
+}
+
+bool BookCache::unchangedSince(int book_id, std::uint64_t seen_generation) const
+{
+    return invalidated_at_[stripe(book_id)].load(std::memory_order_acquire) <= seen_generation &&
+           cleared_at_.load(std::memory_order_acquire) <= seen_generation;
+}
+
+void BookCache::put(const Book& book, std::uint64_t seen_generation)
+{
+    const int book_id = book.getId();
+    if (book_id <= 0) {
+        return;
+    }
+    auto unchanged = [this, book_id, seen_generation]() { return unchangedSince(book_id, seen_generation); };
+
+    auto metadata = std::make_shared<Metadata>();
+    metadata->id = book_id;
+    metadata->isbn = book.getIsbn();
+    metadata->title = book.getTitle();
+    metadata->author = book.getAuthor();
+    metadata->publisher = book.getPublisher();
+    metadata->publish_date = book.getPublishDate();
+    metadata->category = book.getCategory();
+    metadata->total_copies = book.getTotalCopies();
+
+    if (!metadata_.putIf(book_id, std::move(metadata), unchanged)) {
+        return;
+    }
+    availability_.putIf(book_id, book.getAvailableCopies(), unchanged);
+    // 索引条目在 findByIsbn 时与元数据的 isbn 核对, 过期条目不会返回错误的书
+    isbn_index_.putIf(book.getIsbn(), book_id, unchanged);
+}
+
+void BookCache::insert(const Book& book)
+{
+    put(book, mark(book.getId()));
+}
+
+void BookCache::invalidate(int book_id)
+{
+    mark(book_id);
+    if (auto metadata = metadata_.get(book_id)) {
+        isbn_index_.erase((*metadata)->isbn);
+    }
+    metadata_.erase(book_id);
+    availability_.erase(book_id);
+}
+
+void BookCache::invalidateAvailability(int book_id)
+{
+    mark(book_id);
+    availability_.erase(book_id);
+}
+
+void BookCache::clear()
+{
+    auto sequence = sequence_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    cleared_at_.store(sequence, std::memory_order_release);
+    metadata_.clear();
+    availability_.clear();
+    isbn_index_.clear();
+}
+
+BookCacheStats BookCache::stats() const
+{
+    BookCacheStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.metadata = metadata_.stats();
+    stats.availability = availability_.stats();
+    stats.isbn_index = isbn_index_.stats();
+    return stats;
+}
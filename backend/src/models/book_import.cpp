@@ -0,0 +1,62 @@
+// src/models/book_import.cpp
+
+#include "models/book_import.hpp"
+#include "models/book_cache.hpp"
+#include "utils/config.hpp"
+#include "utils/statements.hpp"
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+static std::optional<std::string> nullIfEmpty(const std::string& value)
+{
+    if (value.empty()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+static const PoolSite IMPORT_SITE("BookImport");
+
+BookImport::BookImport()
+    : conn_(DatabasePool::getInstance().getWriteConnection(IMPORT_SITE)),
+      txn_(*conn_)
+{
+    txn_.exec(BOOK_IMPORT_QUIET_SQL);
+    txn_.exec(BOOK_IMPORT_CREATE_SQL);
+    stream_.emplace(txn_, "book_import", std::vector<std::string>{
+        "isbn", "title", "author", "publisher", "publish_date", "category", "total_copies"
+    });
+}
+
+void BookImport::write(const ImportedBook& book)
+{
+    *stream_ << std::make_tuple(
+        book.isbn,
+        book.title,
+        book.author,
+        nullIfEmpty(book.publisher),
+        nullIfEmpty(book.publish_date),
+        nullIfEmpty(book.category),
+        book.total_copies
+    );
+}
+
+BookImport::Result BookImport::commit()
+{
+    stream_->complete();
+    stream_.reset();
+
+    auto counts = txn_.exec(BOOK_IMPORT_MERGE_SQL);
+    // 合并可能改动任意多本书: 逐行通知已被抑制, 其他实例收到一条通知后整体清空
+    txn_.exec_params(BOOK_IMPORT_NOTIFY_SQL, Config::getInstance().get("DB_NOTIFY_CHANNEL"));
+    txn_.commit();
+
+    BookCache::getInstance().clear();
+
+    Result result;
+    result.inserted = counts[0][0].as<long>();
+    result.updated = counts[0][1].as<long>();
+    return result;
+}
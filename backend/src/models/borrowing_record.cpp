@@ -1,22 +1,63 @@
 // src/models/borrowing_record.cpp
 
 #include "models/borrowing_record.hpp"
+#include "models/book_cache.hpp"
+#include "utils/async_query.hpp"
 #include "utils/database_pool.hpp"
+#include "utils/row_mapper.hpp"
+#include "utils/statements.hpp"
 #include <exception>
 #include <iostream>
-#include <ctime>
 #include <memory>
 #include <sys/types.h>
 #include <vector>
 
+// 成员顺序与 SQL_SELECT_LIST(BORROWING_COLUMNS) 一致, 按列下标绑定
+#define BORROWING_MEMBER(column) , &BorrowingRecord::column##_
+template <>
+struct ModelTraits<BorrowingRecord> {
+    static constexpr auto members = std::make_tuple(&BorrowingRecord::id_ BORROWING_COLUMNS(BORROWING_MEMBER));
+};
+#undef BORROWING_MEMBER
+
+std::future<std::vector<std::unique_ptr<BorrowingRecord>>> BorrowingRecord::findByUserIdAsync(int user_id){
+    return AsyncExecutor::getInstance().execPrepared<std::vector<std::unique_ptr<BorrowingRecord>>>(
+        Stmt::borrowing_find_by_user,
+        {std::to_string(user_id)},
+        [](const AsyncResult& result) {
+            std::vector<std::unique_ptr<BorrowingRecord>> records;
+            records.reserve(static_cast<std::size_t>(result.rows()));
+            for (int row = 0; row < result.rows(); row++) {
+                records.push_back(RowMapper<BorrowingRecord>::parse(
+                    [&result, row](int col) { return result.get(row, col); }));
+            }
+            return records;
+        });
+}
+
+std::future<int> BorrowingRecord::countActiveByUserIdAsync(int user_id){
+    return AsyncExecutor::getInstance().execPrepared<int>(
+        Stmt::borrowing_count_active_by_user,
+        {std::to_string(user_id)},
+        [](const AsyncResult& result) { return result.getInt(0, "count"); });
+}
+
+std::future<int> BorrowingRecord::countOverdueByUserIdAsync(int user_id){
+    return AsyncExecutor::getInstance().execPrepared<int>(
+        Stmt::borrowing_count_overdue_by_user,
+        {std::to_string(user_id)},
+        [](const AsyncResult& result) { return result.getInt(0, "count"); });
+}
+
 std::unique_ptr<BorrowingRecord> BorrowingRecord::findById(int id){
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("BorrowingRecord::findById");
+    auto conn = DatabasePool::getInstance().getConnection(site);
 
     try {
-        pqxx::work txn(*conn);
+        pqxx::nontransaction txn(*conn);
 
-        auto result = txn.exec_params(
-            "SELECT * FROM borrowing_records WHERE id = $1",
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_find_by_id,
             id
         );
 
@@ -24,23 +65,7 @@ std::unique_ptr<BorrowingRecord> BorrowingRecord::findById(int id){
             return nullptr;
         }
 
-        const auto& row = result[0];
-
-        auto record = BorrowingRecord::create()
-            .setUserId(row["user_id"].as<int>())
-            .setBookId(row["book_id"].as<int>())
-            .setBorrowDate(row["borrow_date"].as<std::string>())
-            .setReturnDate(row["return_date"].as<std::string>())
-            .build();
-
-        if (!row["return_date"].is_null()) {
-            record->return_date_ = (row["return_date"].as<std::string>());
-        }
-        record->id_ = row["id"].as<int>();
-
-        txn.commit();
-
-        return record;
+        return RowMapper<BorrowingRecord>::map(result[0]);
 
     } catch (const std::exception& e) {
         std::cerr << "Error in BorrowingRecord::findById(): " << e.what() << std::endl;
@@ -50,124 +75,183 @@ std::unique_ptr<BorrowingRecord> BorrowingRecord::findById(int id){
 
 std::vector<std::unique_ptr<BorrowingRecord>> BorrowingRecord::findByUserId(int user_id){
     std::vector<std::unique_ptr<BorrowingRecord>> records;
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("BorrowingRecord::findByUserId");
+    auto conn = DatabasePool::getInstance().getReadConnection(site, user_id);
 
     try {
-        pqxx::work txn(*conn);
+        pqxx::nontransaction txn(*conn);
 
-        auto result = txn.exec_params(
-            "SELECT * FROM borrowing_records WHERE user_id = $1 ORDER BY borrow_date DESC",
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_find_by_user,
             user_id
         );
 
-        for (const auto& row : result) {
-            auto record = BorrowingRecord::create()
-                .setUserId(row["user_id"].as<int>())
-                .setBookId(row["book_id"].as<int>())
-                .setBorrowDate(row["borrow_date"].as<std::string>())
-                .setDueDate(row["due_date"].as<std::string>())
-                .setStatus(row["status"].as<std::string>())
-                .build();
-
-            if (!row["return_date"].is_null()) {
-                record->return_date_ = row["return_date"].as<std::string>();
-            }
+        records = RowMapper<BorrowingRecord>::mapAll(result);
 
-            record->id_ = row["id"].as<int>();
-            records.push_back(std::move(record));
+    } catch (const std::exception& e) {
+        std::cerr << "Error in BorrowingRecord::findByUserId(): " << e.what() << std::endl;
+    }
+    return records;
+}
+
+std::unique_ptr<BorrowingRecord> BorrowingRecord::findActive(int user_id, int book_id){
+    // 结果决定后续写入, 必须读主库, 不能用可能滞后的副本
+    static const PoolSite site("BorrowingRecord::findActive");
+    auto conn = DatabasePool::getInstance().getConnection(site);
+
+    try {
+        pqxx::nontransaction txn(*conn);
+
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_find_active,
+            user_id, book_id
+        );
+
+        if (result.empty()) {
+            return nullptr;
         }
 
-        txn.commit();
+        return RowMapper<BorrowingRecord>::map(result[0]);
 
     } catch (const std::exception& e) {
-        std::cerr << "Error in BorrowingRecord::findByUserId(): " << e.what() << std::endl;
+        std::cerr << "Error in BorrowingRecord::findActive(): " << e.what() << std::endl;
+        return nullptr;
     }
-    return records;
 }
 
 std::vector<std::unique_ptr<BorrowingRecord>> BorrowingRecord::findByBookId(int book_id) {
     std::vector<std::unique_ptr<BorrowingRecord>> records;
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("BorrowingRecord::findByBookId");
+    auto conn = DatabasePool::getInstance().getReadConnection(site);
     try {
-        pqxx::work txn(*conn);
-        auto result = txn.exec_params(
-            "SELECT * FROM borrowing_records "
-            "WHERE book_id = $1 "
-            "ORDER BY borrow_date DESC",
+        pqxx::nontransaction txn(*conn);
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_find_by_book,
             book_id
         );
 
-        for (const auto& row : result) {
-            auto record = BorrowingRecord::create()
-                .setUserId(row["user_id"].as<int>())
-                .setBookId(row["book_id"].as<int>())
-                .setBorrowDate(row["borrow_date"].as<std::string>())
-                .setDueDate(row["due_date"].as<std::string>())
-                .setStatus(row["status"].as<std::string>())
-                .build();
-
-            if (!row["return_date"].is_null()) {
-                record->return_date_ = row["return_date"].as<std::string>();
-            }
-
-            record->id_ = row["id"].as<int>();
-            records.push_back(std::move(record));
-        }
-        txn.commit();
+        records = RowMapper<BorrowingRecord>::mapAll(result);
     } catch (const std::exception& e) {
         std::cerr << "Error in BorrowingRecord::findByBookId(): " << e.what() << std::endl;
     }
     return records;
 }
 
-std::vector<std::unique_ptr<BorrowingRecord>> BorrowingRecord::findOverdue(){
-    std::vector<std::unique_ptr<BorrowingRecord>> records;
-    auto conn = DatabasePool::getInstance().getConnection();
+BorrowingList BorrowingRecord::findOverdue(){
+    static const PoolSite site("BorrowingRecord::findOverdue");
+    auto conn = DatabasePool::getInstance().getConnection(site);
 
     try {
-        pqxx::work txn(*conn);
+        pqxx::nontransaction txn(*conn);
 
-        auto result = txn.exec_params(
-            "SELECT * FROM borrowing_records "
-            "WHERE return_date IS NULL AND due_date < CURRENT_TIMESTAMP"
-            "AND status = 'borrowed'"
-            "ORDER BY borrow_date DESC"
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_find_overdue
         );
 
-        for (const auto& row : result) {
-            auto record = BorrowingRecord::create()
-                .setUserId(row["user_id"].as<int>())
-                .setBookId(row["book_id"].as<int>())
-                .setBorrowDate(row["borrow_date"].as<std::string>())
-                .setDueDate(row["due_date"].as<std::string>())
-                .setStatus(row["status"].as<std::string>())
-                .build();
-
-            if (!row["return_date"].is_null()) {
-                record->return_date_ = row["return_date"].as<std::string>();
-            }
+        return BorrowingList::from(result);
 
-            record->id_ = row["id"].as<int>();
-            records.push_back(std::move(record));
-        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error in BorrowingRecord::findOverdue(): " << e.what() << std::endl;
+        return {};
+    }
+}
 
-        txn.commit();
+LoanList BorrowingRecord::findActiveLoans(int user_id){
+    static const PoolSite site("BorrowingRecord::findActiveLoans");
+    auto conn = DatabasePool::getInstance().getReadConnection(site, user_id);
+
+    try {
+        pqxx::nontransaction txn(*conn);
+
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_active_loans_by_user,
+            user_id
+        );
+
+        return LoanList::from(result);
 
     } catch (const std::exception& e) {
-        std::cerr << "Error in BorrowingRecord::findOverdue(): " << e.what() << std::endl;
+        std::cerr << "Error in BorrowingRecord::findActiveLoans(): " << e.what() << std::endl;
+        return {};
+    }
+}
+
+CursorScan<BorrowingRow> BorrowingRecord::scan(const BorrowingFilter& filter){
+    // 过滤条件只有整数和固定片段, 直接拼进游标查询
+    std::string query = BORROWING_SCAN_SQL;
+    if (filter.user_id > 0) {
+        query += " AND user_id = " + std::to_string(filter.user_id);
+    }
+    if (filter.book_id > 0) {
+        query += " AND book_id = " + std::to_string(filter.book_id);
+    }
+    if (filter.active_only || filter.overdue_only) {
+        query += " AND return_date IS NULL";
+    }
+    if (filter.overdue_only) {
+        query += " AND due_date < CURRENT_TIMESTAMP";
+    }
+    query += " ORDER BY id";
+
+    static const PoolSite site("BorrowingRecord::scan");
+    return CursorScan<BorrowingRow>(query, site);
+}
+
+// 日期先解析再重新格式化, 只有规范的 ISO 8601 文本会拼进 COPY 查询
+static bool toTimestampLiteral(const std::string& value, std::string& literal){
+    if (value.empty()) {
+        literal.clear();
+        return true;
+    }
+    auto timestamp = parseTimestamp(value);
+    if (!timestamp) {
+        return false;
+    }
+    literal = formatTimestamp(*timestamp);
+    return true;
+}
+
+long BorrowingRecord::exportTo(
+    std::ostream& out,
+    ExportFormat format,
+    ExportCompression compression,
+    const std::string& from,
+    const std::string& to
+){
+    std::string from_literal, to_literal;
+    if (!toTimestampLiteral(from, from_literal) || !toTimestampLiteral(to, to_literal)) {
+        std::cerr << "Error in BorrowingRecord::exportTo(): invalid date range" << std::endl;
+        return -1;
+    }
+
+    std::string query = BORROWING_SCAN_SQL;
+    if (!from_literal.empty()) {
+        query += " AND borrow_date >= '" + from_literal + "'::timestamptz";
+    }
+    if (!to_literal.empty()) {
+        query += " AND borrow_date < '" + to_literal + "'::timestamptz";
+    }
+    query += " ORDER BY id";
+
+    static const PoolSite site("BorrowingRecord::exportTo");
+    try {
+        ExportWriter writer(out, format, compression, exportColumns<BorrowingRow>({SQL_COLUMN_LABELS(BORROWING_COLUMNS)}));
+        return exportQuery(query, site, writer);
+    } catch (const std::exception& e) {
+        std::cerr << "Error in BorrowingRecord::exportTo(): " << e.what() << std::endl;
+        return -1;
     }
-    return records;
 }
 
 int BorrowingRecord::countActiveByUserId(int user_id){
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("BorrowingRecord::countActiveByUserId");
+    auto conn = DatabasePool::getInstance().getConnection(site);
 
     try {
-        pqxx::work txn(*conn);
+        pqxx::nontransaction txn(*conn);
 
-        auto result = txn.exec_params(
-            "SELECT COUNT(*) FROM borrowing_records "
-            "WHERE user_id = $1 AND return_date IS NULL",
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_count_active_by_user,
             user_id
         );
 
@@ -184,14 +268,15 @@ int BorrowingRecord::countActiveByUserId(int user_id){
 }
 
 int BorrowingRecord::countOverdueByUserId(int user_id){
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("BorrowingRecord::countOverdueByUserId");
+    auto conn = DatabasePool::getInstance().getConnection(site);
 
     try {
-        pqxx::work txn(*conn);
+        pqxx::nontransaction txn(*conn);
 
-        auto result = txn.exec_params(
-            "SELECT COUNT(*) FROM borrowing_records "
-            "WHERE user_id = $1 AND return_date IS NULL AND due_date < CURRENT_TIMESTAMP"
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_count_overdue_by_user,
+            user_id
         );
 
         if (result.empty()) {
@@ -205,15 +290,127 @@ int BorrowingRecord::countOverdueByUserId(int user_id){
     }
 }
 
+std::unordered_map<int, BorrowingRecord::BorrowStatus> BorrowingRecord::countStatusByUserIds(const std::vector<int>& user_ids){
+    std::unordered_map<int, BorrowStatus> statuses;
+    if (user_ids.empty()) {
+        return statuses;
+    }
+
+    static const PoolSite site("BorrowingRecord::countStatusByUserIds");
+    auto conn = DatabasePool::getInstance().getReadConnection(site);
+
+    try {
+        pqxx::nontransaction txn(*conn);
+
+        // int[] 参数的文本形式 {1,2,3}, 整个名单只占一个参数
+        std::string id_array = "{";
+        for (std::size_t i = 0; i < user_ids.size(); i++) {
+            if (i > 0) {
+                id_array += ',';
+            }
+            id_array += std::to_string(user_ids[i]);
+        }
+        id_array += '}';
+
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_status_by_users,
+            id_array
+        );
+
+        // 没有未还记录的用户不在结果中, 先全部置 0
+        statuses.reserve(user_ids.size());
+        for (int user_id : user_ids) {
+            statuses[user_id] = BorrowStatus{};
+        }
+        for (const auto& row : result) {
+            auto& status = statuses[row[0].as<int>()];
+            status.active_count = row[1].as<int>();
+            status.overdue_count = row[2].as<int>();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error in BorrowingRecord::countStatusByUserIds(): " << e.what() << std::endl;
+        statuses.clear();
+    }
+    return statuses;
+}
+
+BorrowingRecord::BorrowResult BorrowingRecord::borrow(
+    int user_id,
+    int book_id,
+    Timestamp borrow_date,
+    Timestamp due_date,
+    int max_active
+){
+    BorrowResult outcome;
+    static const PoolSite site("BorrowingRecord::borrow");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site, user_id);
+
+    try {
+        // 整个操作是一条语句, 本身即原子; 不包 BEGIN/COMMIT, 只需一次往返
+        pqxx::nontransaction txn(*conn);
+
+        // 函数总是返回一行: refusal, 之后是借阅记录各列 (被拒绝时为 NULL)
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_borrow,
+            user_id, book_id, formatTimestamp(borrow_date), formatTimestamp(due_date), max_active
+        );
+
+        outcome.refusal = static_cast<BorrowRefusal>(result[0][0].as<int>());
+        if (outcome.refusal != BorrowRefusal::NONE) {
+            return outcome;
+        }
+
+        outcome.record = RowMapper<BorrowingRecord>::map(result[0], 1);
+        // 库存由数据库函数增减, 本地只丢弃库存条目
+        BookCache::getInstance().invalidateAvailability(book_id);
+    } catch (const std::exception& e) {
+        std::cerr << "Error in BorrowingRecord::borrow(): " << e.what() << std::endl;
+        outcome.refusal = BorrowRefusal::DATABASE_ERROR;
+        outcome.record.reset();
+    }
+    return outcome;
+}
+
+std::unique_ptr<BorrowingRecord> BorrowingRecord::returnActive(
+    int user_id,
+    int book_id,
+    Timestamp return_date
+){
+    static const PoolSite site("BorrowingRecord::returnActive");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site, user_id);
+
+    try {
+        // 整个操作是一条语句, 本身即原子; 不包 BEGIN/COMMIT, 只需一次往返
+        pqxx::nontransaction txn(*conn);
+
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_return_active,
+            user_id, book_id, formatTimestamp(return_date)
+        );
+
+        if (result.empty()) {
+            return nullptr;
+        }
+
+        auto record = RowMapper<BorrowingRecord>::map(result[0]);
+        // 库存由数据库函数增减, 本地只丢弃库存条目
+        BookCache::getInstance().invalidateAvailability(book_id);
+        return record;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in BorrowingRecord::returnActive(): " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
 bool BorrowingRecord::save(){
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("BorrowingRecord::save");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site, user_id_);
 
     try {
         pqxx::work txn(*conn);
 
-        auto check = txn.exec_params(
-            "SELECT id FROM borrowing_records "
-            "WHERE user_id = $1 AND book_id = $2 AND return_date IS NULL",
+        auto check = txn.exec_prepared(
+            Stmt::borrowing_active_exists,
             user_id_, book_id_
         );
 
@@ -221,10 +418,9 @@ bool BorrowingRecord::save(){
             return false;
         }
 
-        auto result = txn.exec_params(
-            "INSERT INTO borrowing_records (user_id, book_id, borrow_date, due_date, status)"
-            "VALUES ($1, $2, $3, $4, $5) RETURNING id",
-            user_id_, book_id_, borrow_date_, due_date_, status_
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_insert,
+            user_id_, book_id_, formatTimestamp(borrow_date_), formatTimestamp(due_date_), static_cast<int>(status_)
         );
 
         if (!result.empty()) {
@@ -245,16 +441,15 @@ bool BorrowingRecord::update(){
         return false;
     }
 
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("BorrowingRecord::update");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site, user_id_);
 
     try {
         pqxx::work txn(*conn);
 
-        auto result = txn.exec_params(
-            "UPDATE borrowing_records "
-            "SET user_id = $1, book_id = $2, borrow_date = $3, due_date = $4, status = $5 "
-            "WHERE id = $6",
-            user_id_, book_id_, borrow_date_, due_date_, status_, id_
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_update,
+            user_id_, book_id_, formatTimestamp(borrow_date_), formatTimestamp(due_date_), static_cast<int>(status_), id_
         );
 
         txn.commit();
@@ -266,23 +461,22 @@ bool BorrowingRecord::update(){
 
 }
 
-bool BorrowingRecord::return_book(const std::string& return_date){
-    if (id_ == 0 || !return_date_.empty()) {
+bool BorrowingRecord::return_book(Timestamp return_date){
+    if (id_ == 0 || isReturned()) {
         return false;
     }
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("BorrowingRecord::return_book");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site, user_id_);
 
     try {
         pqxx::work txn(*conn);
 
         return_date_ = return_date;
-        status_ = "returned";
+        status_ = Status::RETURNED;
 
-        auto result = txn.exec_params(
-            "UPDATE borrowing_records "
-            "SET return_date = $1, status = $2 "
-            "WHERE id = $3",
-            return_date_, status_, id_
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_return,
+            formatTimestamp(return_date), static_cast<int>(status_), id_
         );
 
         txn.commit();
@@ -294,27 +488,24 @@ bool BorrowingRecord::return_book(const std::string& return_date){
 }
 
 bool BorrowingRecord::renew(){
-    if (id_ == 0 || !return_date_.empty() || status_ == "renewed") {
+    if (id_ == 0 || isReturned() || status_ == Status::RENEWED) {
         return false;
     }
 
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("BorrowingRecord::renew");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site, user_id_);
 
     try {
         pqxx::work txn(*conn);
 
-        auto result = txn.exec_params(
-            "UPDATE borrowing_records SET due_date = due_date + INTERVAL '14 days' status = 'renewed' WHERE id = $1 AND reutrn_date IS NULL",
+        auto result = txn.exec_prepared(
+            Stmt::borrowing_renew,
             id_
         );
 
-        if (result.affected_rows() > 0) {
-           status_ = "renewed";
-
-           auto updated = txn.exec_params(
-            "SELECT due_date FROM borrowing_records WHERE id = $1",id_
-           );
-           due_date_ = updated[0]["due_date"].as<std::string>();
+        if (!result.empty()) {
+           status_ = Status::RENEWED;
+           due_date_ = FieldReader<Timestamp>::read(result[0]["due_date"]);
 
            txn.commit();
            return true;
@@ -326,27 +517,10 @@ bool BorrowingRecord::renew(){
     }
 }
 
-bool BorrowingRecord::isOverdue() const {
-    if (return_date_.empty()) {
-        return false;
-    }
-
-    try {
-        auto conn = DatabasePool::getInstance().getConnection();
-
-        pqxx::work txn(*conn);
-
-        auto result = txn.exec_params(
-            "SELECT due_date < CURRENT_TIMESTAMP as is_overdue FROM borrowing_records WHERE id = $1",
-            id_
-        );
+bool BorrowingRecord::isOverdue(Timestamp now) const {
+    return !isReturned() && due_date_ < now;
+}
 
-        if (!result.empty()){
-           return result[0]["is_overdue"].as<bool>();
-        }
-        return false;
-    } catch (const std::exception& e) {
-        std::cerr << "Error in BorrowingRecord::isOverdue(): " << e.what() << std::endl;
-        return false;
-    }
+bool BorrowingRecord::isOverdue() const {
+    return isOverdue(std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now()));
 }
@@ -2,20 +2,31 @@
 
 #include "models/user.hpp"
 #include "models/book.hpp"
+#include "models/user_directory.hpp"
 #include "utils/database_pool.hpp"
+#include "utils/row_mapper.hpp"
+#include "utils/statements.hpp"
 #include <exception>
 #include <memory>
 #include <string>
 #include <vector>
 #include <iostream>
 
+// 成员顺序与 SQL_SELECT_LIST(USER_COLUMNS) 一致, 按列下标绑定
+#define USER_MEMBER(column) , &User::column##_
+template <>
+struct ModelTraits<User> {
+    static constexpr auto members = std::make_tuple(&User::id_ USER_COLUMNS(USER_MEMBER));
+};
+#undef USER_MEMBER
+
 std::unique_ptr<User> User::findById(int id){
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("User::findById");
+    auto conn = DatabasePool::getInstance().getConnection(site);
     try {
-        pqxx::work txn(*conn);
-        auto result = txn.exec_params(
-                "SELECT id, username, email, password_hash, role"
-                "FROM users WHERE id=$1",
+        pqxx::nontransaction txn(*conn);
+        auto result = txn.exec_prepared(
+                Stmt::user_find_by_id,
                 id
         );
 
@@ -23,30 +34,19 @@ std::unique_ptr<User> User::findById(int id){
             return nullptr;
         }
 
-        auto user = User::create()
-             .setUsername(result[0]["username"].as<std::string>())
-             .setEmail(result[0]["email"].as<std::string>())
-             .setPasswordHash(result[0]["password_hash"].as<std::string>())
-             .setRole(result[0]["role"].as<std::string>())
-             .build();
-
-        user->id_= result[0]["id"].as<int>();
-
-        txn.commit();
-
-        return user;
+        return RowMapper<User>::map(result[0]);
     } catch (const std::exception& e) {
         //TODO: Record err log
         return nullptr;
     }
 }
 std::unique_ptr<User> User::findByUsername(const std::string& username){
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("User::findByUsername");
+    auto conn = DatabasePool::getInstance().getConnection(site);
     try {
-        pqxx::work txn(*conn);
-        auto result = txn.exec_params(
-                "SELECT id, username, email, password_hash, role"
-                "FROM users WHERE username=$1",
+        pqxx::nontransaction txn(*conn);
+        auto result = txn.exec_prepared(
+                Stmt::user_find_by_username,
                 username
         );
 
@@ -54,17 +54,7 @@ std::unique_ptr<User> User::findByUsername(const std::string& username){
             return nullptr;
         }
 
-        auto user = User::create()
-             .setUsername(result[0]["username"].as<std::string>())
-             .setEmail(result[0]["email"].as<std::string>())
-             .setPasswordHash(result[0]["password_hash"].as<std::string>())
-             .setRole(result[0]["role"].as<std::string>())
-             .build();
-
-        user->id_= result[0]["id"].as<int>();
-        txn.commit();
-
-        return user;
+        return RowMapper<User>::map(result[0]);
 
     } catch (const std::exception& e) {
         //TODO: Record err log
@@ -72,14 +62,15 @@ std::unique_ptr<User> User::findByUsername(const std::string& username){
     }
 }
 [[nodiscard]] int Book::count(){
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("Book::count");
+    auto conn = DatabasePool::getInstance().getReadConnection(site);
 
     try {
-        pqxx::work txn(*conn);
+        pqxx::nontransaction txn(*conn);
 
-        auto results = txn.exec1("SELECT COUNT(*) FROM books");
+        auto result = txn.exec_prepared(Stmt::book_count);
 
-        return results[0].as<int>();
+        return result[0][0].as<int>();
     } catch (const std::exception& e) {
         std::cerr << "Error in Book::count(): " << e.what() << std::endl;
         return 0;
@@ -88,38 +79,19 @@ std::unique_ptr<User> User::findByUsername(const std::string& username){
 
 
 std::vector<std::unique_ptr<User>> User::findAll(){
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("User::findAll");
+    auto conn = DatabasePool::getInstance().getConnection(site);
     try {
-        pqxx::work txn(*conn);
-        auto result = txn.exec_params(
-                "SELECT id, username, email, password_hash, role"
-                "FROM users "
+        pqxx::nontransaction txn(*conn);
+        auto result = txn.exec_prepared(
+                Stmt::user_find_all
         );
 
-        if (result.empty()) {
-            return nullptr;
-        }
-
-        std::vector<std::unique_ptr<User>> users;
-
-        for(auto row : result){
-            auto user = User::create()
-                .setUsername(row["username"].as<std::string>())
-                .setEmail(row["email"].as<std::string>())
-                .setPasswordHash(row["password_hash"].as<std::string>())
-                .setRole(row["role"].as<std::string>())
-                .build();
-
-            user->id_= row["id"].as<int>();
-            users.push_back(user);
-        }
-       txn.commit();
-
-        return users;
+        return RowMapper<User>::mapAll(result);
 
     } catch (const std::exception& e) {
         //TODO: Record err log
-        return nullptr;
+        return {};
     }
 
 }
@@ -128,13 +100,14 @@ bool User::save(){
     if (id_ != 0){
         return update();
     }
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("User::save");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site);
 
     try {
         pqxx::work txn(*conn);
 
-        auto check = txn.exec_params(
-            "SELECT id FROM users WHERE username = $1 OR email = $2",
+        auto check = txn.exec_prepared(
+            Stmt::user_conflict,
             username_, email_
         );
 
@@ -142,10 +115,8 @@ bool User::save(){
             return false;
         }
 
-        auto result = txn.exec_params(
-            "INSERT INTO users (username, email, password_hash, role)"
-            "VALUES ($1, $2, $3, $4)"
-            "RETURNING id",
+        auto result = txn.exec_prepared(
+            Stmt::user_insert,
             username_, email_, password_hash_, role_
         );
 
@@ -165,13 +136,14 @@ bool User::update(){
         return false;
     }
 
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("User::update");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site, id_);
 
     try {
         pqxx::work txn(*conn);
 
-        auto check = txn.exec_params(
-            "SELECT id FROM users WHERE (username = $1 OR email = $2) AND id != $3",
+        auto check = txn.exec_prepared(
+            Stmt::user_update_conflict,
             username_, email_, id_
         );
 
@@ -179,14 +151,13 @@ bool User::update(){
             return false; //Username or email conflict
         }
 
-        auto result = txn.exec_params(
-            "UPDATE users"
-            "SET username = $1, email = $2, password_hash = $3, role = $4"
-            "WHERE id = $5",
+        auto result = txn.exec_prepared(
+            Stmt::user_update,
             username_, email_, password_hash_, role_, id_
         );
 
         txn.commit();
+        UserDirectory::getInstance().invalidate(id_);
         return result.affected_rows() > 0;
    } catch (const std::exception& e) {
         //TODO
@@ -198,14 +169,15 @@ bool User::remove(){
         return false;
     }
 
-    auto conn = DatabasePool::getInstance().getConnection();
+    static const PoolSite site("User::remove");
+    auto conn = DatabasePool::getInstance().getWriteConnection(site, id_);
 
     try {
         pqxx::work txn(*conn);
 
         //Check if borrow rec exists.
-        auto check = txn.exec_params(
-            "SELECT id FROM borrowing_records WHERE user_id = $1 AND return_date IS NULL",
+        auto check = txn.exec_prepared(
+            Stmt::user_has_active_borrowings,
             id_
         );
 
@@ -213,12 +185,13 @@ bool User::remove(){
             return false;//user has unreturned book cannot del
         }
 
-        auto result = txn.exec_params(
-            "DELETE FROM users WHERE id = $1",
+        auto result = txn.exec_prepared(
+            Stmt::user_delete,
             id_
         );
 
         txn.commit();
+        UserDirectory::getInstance().invalidate(id_);
         return result.affected_rows() > 0;
 
     } catch (const std::exception& e) {
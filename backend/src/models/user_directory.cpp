@@ -0,0 +1,266 @@
+// src/models/user_directory.cpp
+
+#include "models/user_directory.hpp"
+#include "utils/database_pool.hpp"
+#include "utils/invalidation_listener.hpp"
+#include "utils/statements.hpp"
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <mutex>
+
+UserDirectory::UserDirectory()
+{
+    slots_.resize(USER_DIRECTORY_RESERVE);
+
+    subscriptions_.push_back(InvalidationListener::getInstance().subscribe(
+        "users",
+        [this](const std::vector<int>& ids) {
+            for (int user_id : ids) {
+                invalidate(user_id);
+            }
+        },
+        [this]() { clear(); }));
+}
+
+UserDirectory::~UserDirectory()
+{
+    auto& listener = InvalidationListener::getInstance();
+    for (int subscription : subscriptions_) {
+        listener.unsubscribe(subscription);
+    }
+}
+
+std::optional<UserIdentity> UserDirectory::find(int user_id)
+{
+    if (user_id <= 0) {
+        return std::nullopt;
+    }
+    if (auto identity = lookup(user_id)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return identity;
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return load(user_id);
+}
+
+std::optional<UserIdentity> UserDirectory::lookup(int user_id) const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const Slot* slot = findSlot(user_id);
+    if (slot == nullptr) {
+        return std::nullopt;
+    }
+
+    const Entry& entry = slot->entry;
+    UserIdentity identity;
+    identity.id = user_id;
+    identity.username.assign(names_, entry.name_offset, entry.name_length);
+    identity.role = roles_[entry.role];
+    identity.active = (entry.flags & FLAG_ACTIVE) != 0;
+    return identity;
+}
+
+std::optional<UserIdentity> UserDirectory::load(int user_id)
+{
+    auto generation = generation_.load(std::memory_order_acquire);
+    static const PoolSite site("UserDirectory::load");
+    auto conn = DatabasePool::getInstance().getConnection(site);
+
+    try {
+        pqxx::nontransaction txn(*conn);
+
+        auto result = txn.exec_prepared(
+            Stmt::user_identity_by_id,
+            user_id
+        );
+
+        if (result.empty()) {
+            return std::nullopt;
+        }
+
+        UserIdentity identity;
+        identity.id = user_id;
+        identity.username = result[0][1].as<std::string>();
+        identity.role = result[0][2].is_null() ? std::string() : result[0][2].as<std::string>();
+        identity.active = true;
+
+        insert(user_id, identity.username, identity.role, generation);
+        return identity;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in UserDirectory::load(): " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+void UserDirectory::insert(int user_id, const std::string& username, const std::string& role, std::uint64_t seen_generation)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    // 查询期间有过失效, 结果可能已过期, 不回填
+    if (generation_.load(std::memory_order_acquire) != seen_generation) {
+        return;
+    }
+    if (username.size() > std::numeric_limits<std::uint16_t>::max() ||
+        names_.size() + username.size() > std::numeric_limits<std::uint32_t>::max()) {
+        return;
+    }
+
+    eraseLocked(user_id);
+
+    Entry entry;
+    entry.name_offset = static_cast<std::uint32_t>(names_.size());
+    entry.name_length = static_cast<std::uint16_t>(username.size());
+    entry.role = roleIndex(role);
+    entry.flags = FLAG_ACTIVE;
+
+    names_ += username;
+    insertSlot(user_id, entry);
+}
+
+std::uint8_t UserDirectory::roleIndex(const std::string& role)
+{
+    for (std::size_t i = 0; i < roles_.size(); i++) {
+        if (roles_[i] == role) {
+            return static_cast<std::uint8_t>(i);
+        }
+    }
+    if (roles_.size() > std::numeric_limits<std::uint8_t>::max()) {
+        return 0;
+    }
+    roles_.push_back(role);
+    return static_cast<std::uint8_t>(roles_.size() - 1);
+}
+
+void UserDirectory::eraseLocked(int user_id)
+{
+    const Slot* slot = findSlot(user_id);
+    if (slot == nullptr) {
+        return;
+    }
+    garbage_bytes_ += slot->entry.name_length;
+    eraseSlot(static_cast<std::size_t>(slot - slots_.data()));
+
+    // 超过一半是失效数据时整理存储区
+    if (garbage_bytes_ > names_.size() / 2) {
+        compactLocked();
+    }
+}
+
+void UserDirectory::compactLocked()
+{
+    std::string names;
+    names.reserve(names_.size() - garbage_bytes_);
+    for (auto& slot : slots_) {
+        if (slot.user_id == 0) {
+            continue;
+        }
+        auto offset = static_cast<std::uint32_t>(names.size());
+        names.append(names_, slot.entry.name_offset, slot.entry.name_length);
+        slot.entry.name_offset = offset;
+    }
+    names_ = std::move(names);
+    garbage_bytes_ = 0;
+}
+
+void UserDirectory::invalidate(int user_id)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    eraseLocked(user_id);
+}
+
+void UserDirectory::clear()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    slots_.assign(USER_DIRECTORY_RESERVE, Slot{});
+    size_ = 0;
+    names_.clear();
+    garbage_bytes_ = 0;
+}
+
+std::size_t UserDirectory::home(int user_id) const
+{
+    // 乘法散列打散连续的 id, 容量是 2 的幂, 取高位再按掩码截断
+    auto hash = static_cast<std::uint64_t>(static_cast<std::uint32_t>(user_id)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<std::size_t>(hash >> 32) & (slots_.size() - 1);
+}
+
+const UserDirectory::Slot* UserDirectory::findSlot(int user_id) const
+{
+    const std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = home(user_id);; i = (i + 1) & mask) {
+        const Slot& slot = slots_[i];
+        if (slot.user_id == user_id) {
+            return &slot;
+        }
+        if (slot.user_id == 0) {
+            return nullptr;
+        }
+    }
+}
+
+void UserDirectory::insertSlot(int user_id, const Entry& entry)
+{
+    // 装载率保持在 3/4 以下, 探测链保持很短, 也保证总有空槽结束查找
+    if ((size_ + 1) * 4 > slots_.size() * 3) {
+        rehash(slots_.size() * 2);
+    }
+
+    const std::size_t mask = slots_.size() - 1;
+    std::size_t i = home(user_id);
+    while (slots_[i].user_id != 0 && slots_[i].user_id != user_id) {
+        i = (i + 1) & mask;
+    }
+    if (slots_[i].user_id == 0) {
+        size_++;
+    }
+    slots_[i].user_id = user_id;
+    slots_[i].entry = entry;
+}
+
+/*
+Backward-shift deletion: later slots of the same probe chain move up into
+the hole, so lookups never need tombstones
+*/
+void UserDirectory::eraseSlot(std::size_t index)
+{
+    const std::size_t mask = slots_.size() - 1;
+    std::size_t hole = index;
+    for (std::size_t i = (hole + 1) & mask; slots_[i].user_id != 0; i = (i + 1) & mask) {
+        // slots_[i] may fill the hole only if its home is not between the hole and i (cyclically)
+        std::size_t from_home = (i - home(slots_[i].user_id)) & mask;
+        std::size_t from_hole = (i - hole) & mask;
+        if (from_home >= from_hole) {
+            slots_[hole] = slots_[i];
+            hole = i;
+        }
+    }
+    slots_[hole] = Slot{};
+    size_--;
+}
+
+void UserDirectory::rehash(std::size_t capacity)
+{
+    std::vector<Slot> old(capacity);
+    old.swap(slots_);
+    size_ = 0;
+    for (const auto& slot : old) {
+        if (slot.user_id != 0) {
+            insertSlot(slot.user_id, slot.entry);
+        }
+    }
+}
+
+UserDirectoryStats UserDirectory::stats() const
+{
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    UserDirectoryStats stats;
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    stats.entries = size_;
+    stats.slot_bytes = slots_.size() * sizeof(Slot);
+    stats.name_bytes = names_.size();
+    return stats;
+}
@@ -0,0 +1,437 @@
+// src/services/book_import_service.cpp
+
+#include "services/book_service.hpp"
+#include "models/book_import.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// CSV 默认列顺序, 有表头时按表头重新映射
+enum ImportField {
+    FIELD_ISBN,
+    FIELD_TITLE,
+    FIELD_AUTHOR,
+    FIELD_PUBLISHER,
+    FIELD_PUBLISH_DATE,
+    FIELD_CATEGORY,
+    FIELD_TOTAL_COPIES,
+    FIELD_COUNT
+};
+
+struct ParsedLine {
+    long line{0};
+    ImportedBook book;
+    std::string error;      // 为空表示该行可以导入
+};
+
+// 一批输入行及其解析结果
+struct ImportChunk {
+    std::vector<std::string> lines;
+    std::vector<long> line_numbers;
+    std::vector<ParsedLine> parsed;
+
+    void clear() {
+        lines.clear();
+        line_numbers.clear();
+        parsed.clear();
+    }
+};
+
+static std::string trim(std::string_view text)
+{
+    auto begin = text.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    auto end = text.find_last_not_of(" \t");
+    return std::string(text.substr(begin, end - begin + 1));
+}
+
+/*
+Split one CSV line, "" inside quotes is a literal quote.
+Returns false for an unterminated quote (quoted line breaks are not supported).
+*/
+static bool splitCsv(std::string_view line, std::vector<std::string>& fields)
+{
+    fields.clear();
+    std::string field;
+    bool quoted = false;
+
+    for (std::size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                field.push_back('"');
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                field.push_back(c);
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.push_back(trim(field));
+            field.clear();
+        } else {
+            field.push_back(c);
+        }
+    }
+    fields.push_back(trim(field));
+    return !quoted;
+}
+
+static int fieldByName(std::string name)
+{
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (name == "isbn") return FIELD_ISBN;
+    if (name == "title") return FIELD_TITLE;
+    if (name == "author") return FIELD_AUTHOR;
+    if (name == "publisher") return FIELD_PUBLISHER;
+    if (name == "publish_date" || name == "publishdate") return FIELD_PUBLISH_DATE;
+    if (name == "category") return FIELD_CATEGORY;
+    if (name == "total_copies" || name == "totalcopies") return FIELD_TOTAL_COPIES;
+    return -1;
+}
+
+/*
+If the first line is a header (it names an isbn column), map its columns onto fields and return true
+*/
+static bool parseCsvHeader(const std::string& line, std::vector<int>& columns)
+{
+    std::vector<std::string> names;
+    if (!splitCsv(line, names)) {
+        return false;
+    }
+
+    std::vector<int> mapped;
+    for (const auto& name : names) {
+        mapped.push_back(fieldByName(name));
+    }
+    if (std::find(mapped.begin(), mapped.end(), FIELD_ISBN) == mapped.end()) {
+        return false;   // 数据行, 按默认列顺序解析
+    }
+
+    columns = std::move(mapped);
+    for (int required : {FIELD_ISBN, FIELD_TITLE, FIELD_AUTHOR}) {
+        if (std::find(columns.begin(), columns.end(), required) == columns.end()) {
+            throw std::invalid_argument("CSV header must contain isbn, title and author");
+        }
+    }
+    return true;
+}
+
+static std::string parseCopies(const std::string& text, int& copies)
+{
+    if (text.empty()) {
+        copies = 1;
+        return {};
+    }
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), copies);
+    if (ec != std::errc() || ptr != text.data() + text.size()) {
+        return "total_copies is not an integer";
+    }
+    return {};
+}
+
+static std::string parseCsvLine(const std::string& line, const std::vector<int>& columns, ImportedBook& book)
+{
+    std::vector<std::string> fields;
+    if (!splitCsv(line, fields)) {
+        return "Unterminated quoted field";
+    }
+    if (fields.size() != columns.size()) {
+        return "Expected " + std::to_string(columns.size()) + " columns, got " + std::to_string(fields.size());
+    }
+
+    std::string copies;
+    for (std::size_t i = 0; i < fields.size(); i++) {
+        switch (columns[i]) {
+            case FIELD_ISBN: book.isbn = std::move(fields[i]); break;
+            case FIELD_TITLE: book.title = std::move(fields[i]); break;
+            case FIELD_AUTHOR: book.author = std::move(fields[i]); break;
+            case FIELD_PUBLISHER: book.publisher = std::move(fields[i]); break;
+            case FIELD_PUBLISH_DATE: book.publish_date = std::move(fields[i]); break;
+            case FIELD_CATEGORY: book.category = std::move(fields[i]); break;
+            case FIELD_TOTAL_COPIES: copies = std::move(fields[i]); break;
+            default: break;     // 未知列忽略
+        }
+    }
+    return parseCopies(copies, book.total_copies);
+}
+
+static std::string parseJsonLine(const std::string& line, ImportedBook& book)
+{
+    try {
+        auto object = nlohmann::json::parse(line);
+        if (!object.is_object()) {
+            return "Line is not a JSON object";
+        }
+
+        book.isbn = trim(object.value("isbn", std::string()));
+        book.title = trim(object.value("title", std::string()));
+        book.author = trim(object.value("author", std::string()));
+        book.publisher = trim(object.value("publisher", std::string()));
+        book.publish_date = trim(object.value("publishDate", std::string()));
+        book.category = trim(object.value("category", std::string()));
+        book.total_copies = object.value("totalCopies", 1);
+        return {};
+    } catch (const std::exception& e) {
+        return std::string("Invalid JSON: ") + e.what();
+    }
+}
+
+/*
+Same rules as Book::BookBuilder plus the column limits of the books table.
+ISBN hyphens and spaces are dropped.
+*/
+static std::string validate(ImportedBook& book)
+{
+    book.isbn.erase(std::remove_if(book.isbn.begin(), book.isbn.end(),
+                                   [](char c) { return c == '-' || c == ' '; }),
+                    book.isbn.end());
+
+    if (book.isbn.empty() || book.title.empty() || book.author.empty()) {
+        return "ISBN, Title, Author must have a value";
+    }
+    if (book.isbn.size() != 10 && book.isbn.size() != 13) {
+        return "ISBN must have 10 or 13 digits";
+    }
+    for (std::size_t i = 0; i < book.isbn.size(); i++) {
+        char c = book.isbn[i];
+        bool check_digit_x = i == book.isbn.size() - 1 && book.isbn.size() == 10 && (c == 'X' || c == 'x');
+        if (!std::isdigit(static_cast<unsigned char>(c)) && !check_digit_x) {
+            return "ISBN must have 10 or 13 digits";
+        }
+    }
+    if (book.title.size() > 255 || book.author.size() > 100 ||
+        book.publisher.size() > 100 || book.category.size() > 50) {
+        return "Field too long";
+    }
+    if (!book.publish_date.empty()) {
+        const auto& date = book.publish_date;
+        bool valid = date.size() == 10 && date[4] == '-' && date[7] == '-';
+        for (std::size_t i = 0; valid && i < date.size(); i++) {
+            valid = i == 4 || i == 7 || std::isdigit(static_cast<unsigned char>(date[i]));
+        }
+        if (!valid) {
+            return "publish_date must be YYYY-MM-DD";
+        }
+    }
+    if (book.total_copies < 1) {
+        return "total_copies must be positive";
+    }
+    return {};
+}
+
+static void parseLine(const std::string& text, long line_number, ImportFormat format,
+                      const std::vector<int>& columns, ParsedLine& out)
+{
+    out.line = line_number;
+    out.error = format == ImportFormat::CSV
+        ? parseCsvLine(text, columns, out.book)
+        : parseJsonLine(text, out.book);
+    if (out.error.empty()) {
+        out.error = validate(out.book);
+    }
+}
+
+/*
+Worker threads that live for one import. start() hands them a chunk and returns;
+they take IMPORT_PARSE_BLOCK lines at a time until it is done, while the caller
+reads the next chunk and streams the previous one into COPY. wait() blocks until
+the chunk is fully parsed. One chunk at a time.
+*/
+class ParsePool {
+public:
+    ParsePool(ImportFormat format, const std::vector<int>& columns)
+        : format_(format), columns_(columns)
+    {
+        std::size_t workers = std::max(1u, std::thread::hardware_concurrency());
+        for (std::size_t i = 0; i < workers; i++) {
+            workers_.emplace_back([this] { run(); });
+        }
+    }
+
+    ~ParsePool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ParsePool(const ParsePool&) = delete;
+    ParsePool& operator=(const ParsePool&) = delete;
+
+    void start(ImportChunk& chunk) {
+        chunk.parsed.clear();
+        chunk.parsed.resize(chunk.lines.size());
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            chunk_ = chunk.lines.empty() ? nullptr : &chunk;
+            next_ = 0;
+            remaining_ = chunk.lines.size();
+        }
+        work_cv_.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return chunk_ == nullptr; });
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            work_cv_.wait(lock, [this] {
+                return stopping_ || (chunk_ != nullptr && next_ < chunk_->lines.size());
+            });
+            if (stopping_) {
+                return;
+            }
+
+            ImportChunk& chunk = *chunk_;
+            std::size_t begin = next_;
+            std::size_t end = std::min(begin + IMPORT_PARSE_BLOCK, chunk.lines.size());
+            next_ = end;
+
+            lock.unlock();
+            for (std::size_t i = begin; i < end; i++) {
+                parseLine(chunk.lines[i], chunk.line_numbers[i], format_, columns_, chunk.parsed[i]);
+            }
+            lock.lock();
+
+            remaining_ -= end - begin;
+            if (remaining_ == 0) {
+                chunk_ = nullptr;
+                done_cv_.notify_all();
+            }
+        }
+    }
+
+    ImportFormat format_;
+    const std::vector<int>& columns_;   // fixed once the header has been read
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    ImportChunk* chunk_{nullptr};       // chunk being parsed, nullptr when idle
+    std::size_t next_{0};               // first line not yet taken by a worker
+    std::size_t remaining_{0};          // lines not yet parsed
+    bool stopping_{false};
+    std::vector<std::thread> workers_;
+};
+
+ImportReport BookService::importBooks(std::istream& input, ImportFormat format){
+    ImportReport report;
+
+    auto reject = [&report](long line, std::string message) {
+        report.rejected++;
+        if (report.errors.size() < MAX_IMPORT_ERRORS) {
+            report.errors.push_back({line, std::move(message)});
+        }
+    };
+
+    try {
+        BookImport import;
+        std::unordered_set<std::string> seen_isbns;
+
+        std::vector<int> columns;
+        for (int field = 0; field < FIELD_COUNT; field++) {
+            columns.push_back(field);
+        }
+
+        // 两个批次交替使用: filling 读入新行, parsing 交给解析线程.
+        // 一批解析完成后, 下一批开始解析的同时把这一批写入 COPY 流
+        ImportChunk chunks[2];
+        ImportChunk* filling = &chunks[0];
+        ImportChunk* parsing = &chunks[1];
+        for (auto& chunk : chunks) {
+            chunk.lines.reserve(IMPORT_CHUNK_LINES);
+            chunk.line_numbers.reserve(IMPORT_CHUNK_LINES);
+        }
+        std::optional<ParsePool> pool;
+
+        // 解析结果按输入顺序写入 COPY 流, 同一 ISBN 只保留第一次出现
+        auto write = [&](ImportChunk& chunk) {
+            for (auto& row : chunk.parsed) {
+                if (!row.error.empty()) {
+                    reject(row.line, std::move(row.error));
+                    continue;
+                }
+                if (!seen_isbns.insert(row.book.isbn).second) {
+                    reject(row.line, "Duplicate ISBN " + row.book.isbn);
+                    continue;
+                }
+                import.write(row.book);
+            }
+            chunk.clear();
+        };
+
+        auto flush = [&]() {
+            if (!pool) {
+                pool.emplace(format, columns);  // 表头已处理, 列映射不再变化
+            }
+            pool->wait();
+            std::swap(filling, parsing);
+            pool->start(*parsing);
+            write(*filling);
+        };
+
+        std::string line;
+        long line_number = 0;
+        bool header_checked = format != ImportFormat::CSV;
+
+        while (std::getline(input, line)) {
+            line_number++;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.find_first_not_of(" \t") == std::string::npos) {
+                continue;
+            }
+            if (!header_checked) {
+                header_checked = true;
+                if (parseCsvHeader(line, columns)) {
+                    continue;
+                }
+            }
+
+            report.rows_read++;
+            filling->lines.push_back(std::move(line));
+            filling->line_numbers.push_back(line_number);
+            if (filling->lines.size() >= IMPORT_CHUNK_LINES) {
+                flush();
+            }
+        }
+        flush();
+        pool->wait();
+        write(*parsing);
+
+        auto result = import.commit();
+        report.inserted = result.inserted;
+        report.updated = result.updated;
+        report.committed = true;
+    } catch (const std::exception& e) {
+        std::cerr << "Error in BookService::importBooks(): " << e.what() << std::endl;
+        report.errors.push_back({0, e.what()});
+    }
+    return report;
+}
@@ -2,10 +2,12 @@
 #include "services/book_service.hpp"
 #include "models/book.hpp"
 #include "models/user.hpp"
-#include "utils/database_pool.hpp"
+#include "services/borrowing_service.hpp"
+#include <algorithm>
 #include <exception>
 #include <memory>
 #include <iostream>
+#include <stdexcept>
 
 std::unique_ptr<Book> BookService::addBook(
     const std::string&  isbn,
@@ -46,38 +48,65 @@ bool BookService::borrowBook(
     int book_id
 ){
     try{
-        auto user = User::findById(user_id);
-            if(user == nullptr){
-            //TODO: logging
-            return false;
-        }
-    
-        auto book = Book::findById(book_id);
-        if(book == nullptr){
-            //TODO: logging
-            return false;
-        }
-    
-        auto conn = DatabasePool::getInstance().getConnection();
-        pqxx::work txn(*conn);
-    
-        //TODO: 
-        //by checking the BorrowingRecords db,
-        //if user borrowed this book return false.
-    
-        if (!book->borrow()){
+        // 与借阅服务走同一条原子路径, 库存扣减和借阅记录一次写入
+        auto result = BorrowingService::getInstance().borrowBook(user_id, book_id);
+        if (result.record == nullptr) {
             //TODO: Loggin
             return false;
         }
-    
-        //TODO:
-        //Create record in BorrowingRecord.db
-    
-        txn.commit();
-    
+
         return true;
         } catch (const std::exception& e){
             //TODO: Logging
         return false;
     }
 }
+
+LoanList BookService::getBorrowedBooks(int user_id){
+    // 借阅记录和图书在同一条查询里关联, 不再逐条查询图书
+    return BorrowingRecord::findActiveLoans(user_id);
+}
+
+BookList BookService::SearchBooks(const std::string& keyword){
+    try {
+        return Book::search(keyword);
+    } catch (const std::exception& e) {
+        std::cerr << "Error in BookService::SearchBooks(): " << e.what() << std::endl;
+        return {};
+    }
+}
+
+BookPage BookService::getAllBooks(const std::string& cursor, int pagesize){
+    PageCursor after;
+    if (!cursor.empty()) {
+        auto decoded = PageCursor::decode(cursor);
+        if (!decoded) {
+            throw std::invalid_argument("Invalid page cursor");
+        }
+        after = std::move(*decoded);
+    }
+
+    pagesize = std::clamp(pagesize, 1, MAX_PAGESIZE);
+
+    BookPage page;
+    page.books = Book::findPage(after, pagesize);
+
+    // 满页才可能还有下一页, 游标指向本页最后一行
+    if (static_cast<int>(page.books.size()) == pagesize) {
+        const auto& last = page.books.back();
+        page.next_cursor = PageCursor{std::string(last.title), last.id}.encode();
+    }
+    return page;
+}
+
+int BookService::getTotalBooks(){
+    return Book::count();
+}
+
+CatalogCounters BookService::getCatalogCounters(){
+    return Book::counters();
+}
+
+long BookService::exportBooks(std::ostream& out, ExportFormat format, ExportCompression compression){
+    return Book::exportTo(out, format, compression);
+}
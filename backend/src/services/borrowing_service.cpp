@@ -2,86 +2,50 @@
 
 #include "services/borrowing_service.hpp"
 #include "models/borrowing_record.hpp"
+#include "models/user_directory.hpp"
 #include <chrono>
-#include <ctime>
 #include <exception>
 #include <iostream>
-#include <iomanip>
 #include <memory>
-#include <sstream>
 #include <string>
 #include <vector>
 
-std::unique_ptr<BorrowingRecord> BorrowingService::borrowBook(
+BorrowingRecord::BorrowResult BorrowingService::borrowBook(
     int user_id,
     int book_id,
-    const std::string& borrow_date,
-    const std::string& return_date
+    std::optional<Timestamp> borrow_date,
+    std::optional<Timestamp> due_date
 ){
+    BorrowingRecord::BorrowResult result;
     try {
-        auto user = User::findById(user_id);
-        if (user == nullptr) {
-            return nullptr;
+        // 身份校验走进程内目录, 已知用户不访问数据库
+        if (!UserDirectory::getInstance().exists(user_id)) {
+            result.refusal = BorrowRefusal::USER_NOT_FOUND;
+            return result;
         }
 
-        auto book = Book::findById(book_id);
-        if (book == nullptr) {
-            return nullptr;
-        }
-
-        if (!validateBorrowLimit(user_id)) {
-            return nullptr;
-        }
-
-        if (!validateOverdue(user_id)) {
-            return nullptr;
-        }
-
-        if (!book->borrow()) {
-            return nullptr;
-        }
-
-        std::string borrow_date_str = borrow_date.empty() ? getCurrentDate() : borrow_date;
-        std::string due_date_str = return_date.empty() ? calculateDueDate(borrow_date_str) : return_date;
-
-        auto record = BorrowingRecord::create()
-            .setUserId(user_id)
-            .setBookId(book_id)
-            .setBorrowDate(borrow_date_str)
-            .setDueDate(due_date_str)
-            .setStatus("borrowed")
-            .build();
+        Timestamp borrowed_at = borrow_date.value_or(getCurrentTime());
+        Timestamp due_at = due_date.value_or(calculateDueDate(borrowed_at));
 
-        if (record->save()) {
-            return record;
-        }
-
-        book->return_book();
-        return nullptr;
+        // 校验、扣减库存、写借阅记录在数据库端一次完成, 拒绝原因随结果返回
+        return BorrowingRecord::borrow(user_id, book_id, borrowed_at, due_at, MAX_BORROW_LIMIT);
     } catch (const std::exception& e) {
         std::cerr << "Error in BorrowingService::borrowBook(): " << e.what() << std::endl;
-        return nullptr;
+        result.refusal = BorrowRefusal::DATABASE_ERROR;
+        return result;
     }
 }
 
 bool BorrowingService::returnBook(
     int user_id,
     int book_id,
-    const std::string& return_date)
+    std::optional<Timestamp> return_date)
 {
     try {
-        auto records = BorrowingRecord::findByUserId(user_id);
-        for (const auto& record : records){
-            if (record->getBookId() == book_id && record->getReturnDate().empty()){
-                auto book = Book::findById(book_id);
-                if (!book || !book->return_book()) {
-                    return false;
-                }
-
-                return record->return_book(return_date.empty() ? getCurrentDate() : return_date);
-            }
-        }
-        return false;
+        // 关闭借阅记录并归还库存, 一次往返完成
+        auto record = BorrowingRecord::returnActive(
+            user_id, book_id, return_date.value_or(getCurrentTime()));
+        return record != nullptr;
     } catch (const std::exception& e) {
         std::cerr << "Error in BorrowingService::returnBook(): " << e.what() << std::endl;
         return false;
@@ -94,20 +58,19 @@ bool BorrowingService::renewBook(int user_id, int book_id){
                 return false;
             }
 
-            auto records = BorrowingRecord::findByUserId(user_id);
-            for (const auto& record : records) {
-                if (record->getBookId() == book_id && record->getReturnDate().empty()) {
-                    return record->renew();
-                }
+            // 在主库上查找未归还的记录, 副本可能还看不到刚借出或已归还的状态
+            auto record = BorrowingRecord::findActive(user_id, book_id);
+            if (record == nullptr) {
+                return false;
             }
-            return false;
+            return record->renew();
     } catch (const std::exception& e) {
         std::cerr << "Error in BorrowingService::renewBook(): " << e.what() << std::endl;
         return false;
     }
 }
 
-std::vector<std::unique_ptr<BorrowingRecord>> getUserBorrowings(int user_id, bool include_returned){
+std::vector<std::unique_ptr<BorrowingRecord>> BorrowingService::getUserBorrowings(int user_id, bool include_returned){
     try {
         auto records = BorrowingRecord::findByUserId(user_id);
         if (include_returned) {
@@ -115,8 +78,8 @@ std::vector<std::unique_ptr<BorrowingRecord>> getUserBorrowings(int user_id, boo
         }
 
         std::vector<std::unique_ptr<BorrowingRecord>> active_records;
-        for (const auto& record : records) {
-            if (record->getReturnDate().empty()) {
+        for (auto& record : records) {
+            if (!record->isReturned()) {
                 active_records.push_back(std::move(record));
             }
         }
@@ -136,8 +99,8 @@ std::vector<std::unique_ptr<BorrowingRecord>> BorrowingService::getBookBorrowing
         }
 
         std::vector<std::unique_ptr<BorrowingRecord>> active_records;
-        for (const auto& record : records) {
-            if (record->getReturnDate().empty()) {
+        for (auto& record : records) {
+            if (!record->isReturned()) {
                 active_records.push_back(std::move(record));
             }
         }
@@ -148,7 +111,7 @@ std::vector<std::unique_ptr<BorrowingRecord>> BorrowingService::getBookBorrowing
     }
 }
 
-std::vector<std::unique_ptr<BorrowingRecord>> BorrowingService::getOverdueBooks(){
+BorrowingList BorrowingService::getOverdueBooks(){
     try {
         return BorrowingRecord::findOverdue();
     } catch (const std::exception& e) {
@@ -157,6 +120,16 @@ std::vector<std::unique_ptr<BorrowingRecord>> BorrowingService::getOverdueBooks(
     }
 }
 
+long BorrowingService::exportHistory(
+    std::ostream& out,
+    ExportFormat format,
+    ExportCompression compression,
+    const std::string& from,
+    const std::string& to
+){
+    return BorrowingRecord::exportTo(out, format, compression, from, to);
+}
+
 int BorrowingService::getUserCurrentBorrowCount(int user_id) const{
     try {
         return BorrowingRecord::countActiveByUserId(user_id);
@@ -175,27 +148,26 @@ int BorrowingService::getUserOverdueCount(int user_id) const{
     }
 }
 
-std::string BorrowingService::getCurrentDate() const {
-    auto now = std::chrono::system_clock::now();
-    auto now_c = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&now_c), "%Y-%m-%d");
-    return ss.str();
+std::unordered_map<int, BorrowingRecord::BorrowStatus>
+BorrowingService::getUserBorrowStatuses(const std::vector<int>& user_ids) const{
+    try {
+        return BorrowingRecord::countStatusByUserIds(user_ids);
+    } catch (const std::exception& e) {
+        std::cerr << "Error in BorrowingService::getUserBorrowStatuses(): " << e.what() << std::endl;
+        return {};
+    }
 }
 
+Timestamp BorrowingService::getCurrentTime() {
+    return std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+}
 
-std::string BorrowingService::calculateDueDate(const std::string& borrow_date) const {
-    std::tm borrow_date_tm = {};
-    std::istringstream ss(borrow_date);
-    ss >> std::get_time(&borrow_date_tm, "%Y-%m-%d");
-    borrow_date_tm.tm_mday += MAX_BORROW_TIME;
-    std::stringstream due_date_ss;
-    due_date_ss << std::put_time(&borrow_date_tm, "%Y-%m-%d");
-    return due_date_ss.str();
+Timestamp BorrowingService::calculateDueDate(Timestamp borrow_date) {
+    return borrow_date + std::chrono::days{MAX_BORROW_TIME};
 }
 
 bool BorrowingService::validateBorrowLimit(int user_id) const {
-    return getUserCurrentBorrowCount(user_id) < 3;
+    return getUserCurrentBorrowCount(user_id) < MAX_BORROW_LIMIT;
 }
 
 bool BorrowingService::validateOverdue(int user_id) const {
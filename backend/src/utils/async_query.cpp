@@ -0,0 +1,469 @@
+// src/utils/async_query.cpp
+
+#include "utils/async_query.hpp"
+#include "utils/config.hpp"
+#include "utils/database_pool.hpp"
+#include "utils/statements.hpp"
+#include <algorithm>
+#include <charconv>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <stdexcept>
+#include <unistd.h>
+#include <utility>
+
+int AsyncResult::getInt(int row, const char* name) const {
+    auto text = get(row, name);
+    int value = 0;
+    auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size()) {
+        throw std::runtime_error(std::string("AsyncResult::getInt(): not an integer in column ") + name);
+    }
+    return value;
+}
+
+AsyncExecutor::AsyncExecutor() {
+    Config& config = Config::getInstance();
+    conn_str_ = DatabasePool::connectionString(config.get("DB_HOST"), config.get("DB_PORT"));
+    connections_.resize(static_cast<std::size_t>(std::max(1, config.getInt("DB_ASYNC_CONNECTIONS", 4))));
+    connect_timeout_ = std::chrono::seconds(std::max(1, config.getInt("DB_ASYNC_CONNECT_TIMEOUT_SEC", 5)));
+    retry_delay_ = std::chrono::milliseconds(std::max(0, config.getInt("DB_ASYNC_RETRY_MS", 1000)));
+
+    forEachStatement([this](const char* name, const char* sql) { statements_.emplace_back(name, sql); });
+
+    if (pipe(wake_fds_) != 0) {
+        throw std::runtime_error("AsyncExecutor(): failed to create wake-up pipe");
+    }
+    fcntl(wake_fds_[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_fds_[1], F_SETFL, O_NONBLOCK);
+
+    // Connections are opened by the loop thread so construction never blocks on the network
+    loop_thread_ = std::thread([this] { eventLoop(); });
+}
+
+AsyncExecutor::~AsyncExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake();
+    if (loop_thread_.joinable()) {
+        loop_thread_.join();
+    }
+
+    for (auto& connection : connections_) {
+        if (connection.conn != nullptr) {
+            PQfinish(connection.conn);
+        }
+    }
+    close(wake_fds_[0]);
+    close(wake_fds_[1]);
+}
+
+void AsyncExecutor::submit(const char* statement, std::vector<std::string> params, Callback on_done) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            on_done({}, std::make_exception_ptr(std::runtime_error("AsyncExecutor is shutting down")));
+            return;
+        }
+        queue_.push_back({statement, std::move(params), std::move(on_done)});
+    }
+    wake();
+}
+
+std::future<AsyncResult> AsyncExecutor::execPrepared(const char* statement, std::vector<std::string> params) {
+    auto promise = std::make_shared<std::promise<AsyncResult>>();
+    auto future = promise->get_future();
+
+    submit(statement, std::move(params), [promise](AsyncResult result, std::exception_ptr error) {
+        if (error) {
+            promise->set_exception(error);
+        }
+        else {
+            promise->set_value(std::move(result));
+        }
+    });
+    return future;
+}
+
+void AsyncExecutor::wake() {
+    const char byte = 1;
+    // A full pipe already guarantees a pending wake-up, so the result can be ignored
+    [[maybe_unused]] auto written = write(wake_fds_[1], &byte, 1);
+}
+
+/*
+Begin opening a connection without blocking, eventLoop() drives it through continueConnect()
+*/
+void AsyncExecutor::startConnect(Connection& connection) {
+    connection.conn = PQconnectStart(conn_str_.c_str());
+    if (connection.conn == nullptr) {
+        failConnect(connection, "out of memory");
+        return;
+    }
+    if (PQstatus(connection.conn) == CONNECTION_BAD) {
+        failConnect(connection, PQerrorMessage(connection.conn));
+        return;
+    }
+
+    PQsetnonblocking(connection.conn, 1);
+    connection.state = State::Connecting;
+    connection.polling = PGRES_POLLING_WRITING;
+    connection.deadline = std::chrono::steady_clock::now() + connect_timeout_;
+}
+
+void AsyncExecutor::continueConnect(Connection& connection) {
+    connection.polling = PQconnectPoll(connection.conn);
+    if (connection.polling == PGRES_POLLING_FAILED) {
+        failConnect(connection, PQerrorMessage(connection.conn));
+        return;
+    }
+    if (connection.polling == PGRES_POLLING_OK) {
+        connection.state = State::Preparing;
+        connection.prepared = 0;
+        sendPrepare(connection);
+    }
+}
+
+/*
+Send the next statement of the catalog; a connection carries one command at a time,
+so onPrepared() sends the following one when this one completes
+*/
+bool AsyncExecutor::sendPrepare(Connection& connection) {
+    if (connection.prepared == statements_.size()) {
+        connection.state = State::Ready;
+        connection.flushing = false;
+        return true;
+    }
+
+    const auto& [name, sql] = statements_[connection.prepared];
+    if (PQsendPrepare(connection.conn, name, sql, 0, nullptr) == 0) {
+        failConnect(connection, PQerrorMessage(connection.conn));
+        return false;
+    }
+
+    int flushed = PQflush(connection.conn);
+    if (flushed < 0) {
+        failConnect(connection, PQerrorMessage(connection.conn));
+        return false;
+    }
+    connection.flushing = flushed == 1;
+    return true;
+}
+
+void AsyncExecutor::onPrepared(Connection& connection) {
+    if (PQconsumeInput(connection.conn) == 0) {
+        failConnect(connection, PQerrorMessage(connection.conn));
+        return;
+    }
+
+    while (PQisBusy(connection.conn) == 0) {
+        PGresult* result = PQgetResult(connection.conn);
+        if (result == nullptr) {
+            connection.prepared++;
+            sendPrepare(connection);
+            return;
+        }
+
+        // A statement that fails to prepare is reported and skipped, the others stay usable
+        if (PQresultStatus(result) != PGRES_COMMAND_OK) {
+            std::cerr << "Error in AsyncExecutor::onPrepared(): preparing " << statements_[connection.prepared].first
+                      << ": " << PQresultErrorMessage(result) << std::endl;
+        }
+        PQclear(result);
+    }
+}
+
+void AsyncExecutor::failConnect(Connection& connection, const std::string& message) {
+    std::cerr << "Error in AsyncExecutor::connect(): " << message << std::endl;
+    last_error_ = message;
+    if (connection.conn != nullptr) {
+        PQfinish(connection.conn);
+        connection.conn = nullptr;
+    }
+    connection.state = State::Closed;
+    connection.flushing = false;
+    connection.retry_at = std::chrono::steady_clock::now() + retry_delay_;
+}
+
+/*
+Close a connection left in an unknown state, dispatch() reopens it on next use
+*/
+void AsyncExecutor::drop(Connection& connection) {
+    PQfinish(connection.conn);
+    connection.conn = nullptr;
+    connection.state = State::Closed;
+    connection.flushing = false;
+    connection.retry_at = std::chrono::steady_clock::now();
+}
+
+/*
+Milliseconds until the nearest connect deadline, -1 when nothing is being opened
+*/
+int AsyncExecutor::pollTimeout() const {
+    auto now = std::chrono::steady_clock::now();
+    int timeout = -1;
+    for (const auto& connection : connections_) {
+        if (connection.state != State::Connecting && connection.state != State::Preparing) {
+            continue;
+        }
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(connection.deadline - now).count();
+        int wait = static_cast<int>(std::max<long long>(0, remaining + 1));
+        timeout = timeout < 0 ? wait : std::min(timeout, wait);
+    }
+    return timeout;
+}
+
+void AsyncExecutor::eventLoop() {
+    for (auto& connection : connections_) {
+        startConnect(connection);
+    }
+
+    std::vector<pollfd> fds;
+    std::vector<Connection*> polled;
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                break;
+            }
+        }
+
+        dispatch();
+
+        fds.clear();
+        polled.clear();
+        fds.push_back({wake_fds_[0], POLLIN, 0});
+        for (auto& connection : connections_) {
+            short events = 0;
+            if (connection.state == State::Connecting) {
+                events = connection.polling == PGRES_POLLING_READING ? POLLIN : POLLOUT;
+            }
+            else if (connection.state == State::Preparing || (connection.state == State::Ready && connection.busy)) {
+                events = POLLIN;
+                if (connection.flushing) {
+                    events |= POLLOUT;
+                }
+            }
+            else {
+                continue;
+            }
+            fds.push_back({PQsocket(connection.conn), events, 0});
+            polled.push_back(&connection);
+        }
+
+        if (poll(fds.data(), fds.size(), pollTimeout()) < 0) {
+            continue;   // EINTR
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char buffer[64];
+            while (read(wake_fds_[0], buffer, sizeof(buffer)) > 0) {
+            }
+        }
+
+        for (std::size_t i = 0; i < polled.size(); i++) {
+            Connection& connection = *polled[i];
+            const short revents = fds[i + 1].revents;
+            if (revents == 0) {
+                continue;
+            }
+
+            if (connection.state == State::Connecting) {
+                continueConnect(connection);
+                continue;
+            }
+
+            if ((revents & POLLOUT) && connection.flushing) {
+                int flushed = PQflush(connection.conn);
+                if (flushed < 0) {
+                    if (connection.state == State::Preparing) {
+                        failConnect(connection, PQerrorMessage(connection.conn));
+                        continue;
+                    }
+                    connection.error = std::make_exception_ptr(std::runtime_error(PQerrorMessage(connection.conn)));
+                    finish(connection);
+                    drop(connection);
+                    continue;
+                }
+                connection.flushing = flushed == 1;
+            }
+
+            if (revents & (POLLIN | POLLERR | POLLHUP)) {
+                if (connection.state == State::Preparing) {
+                    onPrepared(connection);
+                }
+                else {
+                    onReadable(connection);
+                }
+            }
+        }
+
+        // Abandon connection attempts that ran past DB_ASYNC_CONNECT_TIMEOUT_SEC
+        auto now = std::chrono::steady_clock::now();
+        for (auto& connection : connections_) {
+            if ((connection.state == State::Connecting || connection.state == State::Preparing) &&
+                connection.deadline <= now) {
+                failConnect(connection, "timed out opening connection");
+            }
+        }
+    }
+
+    // Fail whatever is still queued or in flight
+    auto shutdown = std::make_exception_ptr(std::runtime_error("AsyncExecutor is shutting down"));
+    for (auto& connection : connections_) {
+        if (connection.busy) {
+            connection.error = shutdown;
+            finish(connection);
+        }
+    }
+    std::deque<Request> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending.swap(queue_);
+    }
+    for (auto& request : pending) {
+        request.on_done({}, shutdown);
+    }
+}
+
+/*
+Hand queued requests to idle connections, oldest request first.
+Requests left over reopen closed connections; if none is open or opening, they fail.
+*/
+void AsyncExecutor::dispatch() {
+    for (auto& connection : connections_) {
+        if (connection.state == State::Ready && !connection.busy && PQstatus(connection.conn) != CONNECTION_OK) {
+            drop(connection);
+        }
+        if (connection.state != State::Ready || connection.busy) {
+            continue;
+        }
+
+        Request request;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty()) {
+                return;
+            }
+            request = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        if (!send(connection, request)) {
+            request.on_done({}, std::make_exception_ptr(std::runtime_error(PQerrorMessage(connection.conn))));
+            if (PQstatus(connection.conn) != CONNECTION_OK) {
+                drop(connection);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            return;
+        }
+    }
+
+    bool opening = false;
+    auto now = std::chrono::steady_clock::now();
+    for (auto& connection : connections_) {
+        if (connection.state == State::Closed && connection.retry_at <= now) {
+            startConnect(connection);
+        }
+        opening = opening || connection.state != State::Closed;
+    }
+    if (opening) {
+        return;
+    }
+
+    // Nothing can serve the queue until a retry succeeds, fail it rather than leave callers waiting
+    std::deque<Request> pending;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending.swap(queue_);
+    }
+    auto error = std::make_exception_ptr(std::runtime_error("AsyncExecutor: no database connection: " + last_error_));
+    for (auto& request : pending) {
+        request.on_done({}, error);
+    }
+}
+
+bool AsyncExecutor::send(Connection& connection, Request& request) {
+    if (PQstatus(connection.conn) != CONNECTION_OK) {
+        return false;
+    }
+
+    std::vector<const char*> values;
+    values.reserve(request.params.size());
+    for (const auto& param : request.params) {
+        values.push_back(param.c_str());
+    }
+
+    if (PQsendQueryPrepared(connection.conn,
+                            request.statement,
+                            static_cast<int>(values.size()),
+                            values.data(),
+                            nullptr,
+                            nullptr,
+                            0) == 0) {
+        return false;
+    }
+
+    int flushed = PQflush(connection.conn);
+    if (flushed < 0) {
+        return false;
+    }
+
+    connection.busy = true;
+    connection.flushing = flushed == 1;
+    connection.last_result = AsyncResult();
+    connection.error = nullptr;
+    connection.on_done = std::move(request.on_done);
+    return true;
+}
+
+void AsyncExecutor::onReadable(Connection& connection) {
+    if (PQconsumeInput(connection.conn) == 0) {
+        connection.error = std::make_exception_ptr(std::runtime_error(PQerrorMessage(connection.conn)));
+        finish(connection);
+        drop(connection);
+        return;
+    }
+
+    while (PQisBusy(connection.conn) == 0) {
+        PGresult* result = PQgetResult(connection.conn);
+        if (result == nullptr) {
+            finish(connection);
+            return;
+        }
+
+        auto status = PQresultStatus(result);
+        if (status == PGRES_FATAL_ERROR || status == PGRES_BAD_RESPONSE) {
+            connection.error = std::make_exception_ptr(std::runtime_error(PQresultErrorMessage(result)));
+            PQclear(result);
+        }
+        else {
+            connection.last_result = AsyncResult(result);
+        }
+    }
+}
+
+void AsyncExecutor::finish(Connection& connection) {
+    auto on_done = std::move(connection.on_done);
+    auto result = std::move(connection.last_result);
+    auto error = std::exchange(connection.error, nullptr);
+    connection.busy = false;
+    connection.flushing = false;
+    connection.on_done = nullptr;
+    connection.last_result = AsyncResult();
+
+    try {
+        on_done(std::move(result), error);
+    } catch (const std::exception& e) {
+        std::cerr << "Error in AsyncExecutor callback: " << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,190 @@
+// src/utils/export_writer.cpp
+
+#include "utils/export_writer.hpp"
+#include "utils/database_pool.hpp"
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+
+ExportWriter::ExportWriter(
+    std::ostream& out,
+    ExportFormat format,
+    ExportCompression compression,
+    std::vector<ExportColumn> columns
+) : out_(out), format_(format), compression_(compression), columns_(std::move(columns))
+{
+    buffer_.reserve(EXPORT_BUFFER_SIZE + 1024);
+
+    if (compression_ == ExportCompression::GZIP) {
+        compressed_.resize(EXPORT_BUFFER_SIZE);
+        // windowBits 15 + 16: gzip container instead of raw zlib
+        if (deflateInit2(&zstream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            throw std::runtime_error("ExportWriter(): deflateInit2 failed");
+        }
+    }
+
+    if (format_ == ExportFormat::CSV) {
+        for (std::size_t col = 0; col < columns_.size(); col++) {
+            if (col > 0) {
+                buffer_.push_back(',');
+            }
+            buffer_ += columns_[col].name;
+        }
+        buffer_.push_back('\n');
+    }
+}
+
+ExportWriter::~ExportWriter()
+{
+    if (compression_ == ExportCompression::GZIP) {
+        deflateEnd(&zstream_);
+    }
+}
+
+void ExportWriter::beginRow()
+{
+    if (format_ == ExportFormat::NDJSON) {
+        buffer_.push_back('{');
+    }
+}
+
+void ExportWriter::writeField(std::size_t col, std::string_view value, bool is_null)
+{
+    if (format_ == ExportFormat::CSV) {
+        if (col > 0) {
+            buffer_.push_back(',');
+        }
+        if (!is_null) {
+            appendCsv(value);
+        }
+        return;
+    }
+
+    if (col > 0) {
+        buffer_.push_back(',');
+    }
+    appendJsonString(columns_[col].name);
+    buffer_.push_back(':');
+    if (is_null) {
+        buffer_ += "null";
+    } else if (columns_[col].numeric) {
+        buffer_ += value;
+    } else {
+        appendJsonString(value);
+    }
+}
+
+void ExportWriter::endRow()
+{
+    if (format_ == ExportFormat::NDJSON) {
+        buffer_.push_back('}');
+    }
+    buffer_.push_back('\n');
+    rows_++;
+
+    if (buffer_.size() >= EXPORT_BUFFER_SIZE) {
+        flush(false);
+    }
+}
+
+void ExportWriter::appendCsv(std::string_view value)
+{
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+        buffer_ += value;
+        return;
+    }
+
+    buffer_.push_back('"');
+    for (char c : value) {
+        if (c == '"') {
+            buffer_.push_back('"');
+        }
+        buffer_.push_back(c);
+    }
+    buffer_.push_back('"');
+}
+
+void ExportWriter::appendJsonString(std::string_view value)
+{
+    buffer_.push_back('"');
+    for (char c : value) {
+        switch (c) {
+            case '"': buffer_ += "\\\""; break;
+            case '\\': buffer_ += "\\\\"; break;
+            case '\n': buffer_ += "\\n"; break;
+            case '\r': buffer_ += "\\r"; break;
+            case '\t': buffer_ += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[7];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    buffer_ += escaped;
+                } else {
+                    buffer_.push_back(c);
+                }
+        }
+    }
+    buffer_.push_back('"');
+}
+
+void ExportWriter::flush(bool final)
+{
+    if (compression_ == ExportCompression::NONE) {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+        return;
+    }
+
+    zstream_.next_in = reinterpret_cast<Bytef*>(buffer_.data());
+    zstream_.avail_in = static_cast<uInt>(buffer_.size());
+    int flush_mode = final ? Z_FINISH : Z_NO_FLUSH;
+    int status = Z_OK;
+
+    do {
+        zstream_.next_out = reinterpret_cast<Bytef*>(compressed_.data());
+        zstream_.avail_out = static_cast<uInt>(compressed_.size());
+        status = deflate(&zstream_, flush_mode);
+        if (status == Z_STREAM_ERROR) {
+            throw std::runtime_error("ExportWriter::flush(): deflate failed");
+        }
+        out_.write(compressed_.data(), static_cast<std::streamsize>(compressed_.size() - zstream_.avail_out));
+    } while (zstream_.avail_out == 0 || (final && status != Z_STREAM_END));
+
+    buffer_.clear();
+}
+
+bool ExportWriter::finish()
+{
+    if (!finished_) {
+        flush(true);
+        out_.flush();
+        finished_ = true;
+    }
+    return static_cast<bool>(out_);
+}
+
+long exportQuery(const std::string& query, const PoolSite& site, ExportWriter& writer)
+{
+    try {
+        auto conn = DatabasePool::getInstance().getReadConnection(site);
+        pqxx::read_transaction txn(*conn);
+
+        // COPY 逐行读取, 每行写入缓冲区后即丢弃, 内存不随表大小增长
+        auto stream = pqxx::stream_from::query(txn, query);
+        while (auto fields = stream.read_row()) {
+            writer.writeRow(*fields);
+        }
+        stream.complete();
+        txn.commit();
+
+        if (!writer.finish()) {
+            std::cerr << "Error in exportQuery(" << site << "): output stream failed" << std::endl;
+            return -1;
+        }
+        return writer.rows();
+    } catch (const std::exception& e) {
+        std::cerr << "Error in exportQuery(" << site << "): " << e.what() << std::endl;
+        return -1;
+    }
+}
@@ -0,0 +1,250 @@
+// src/utils/invalidation_listener.cpp
+
+#include "utils/invalidation_listener.hpp"
+#include "utils/config.hpp"
+#include "utils/database_pool.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <exception>
+#include <fcntl.h>
+#include <iostream>
+#include <poll.h>
+#include <stdexcept>
+#include <string_view>
+#include <unistd.h>
+
+InvalidationListener::InvalidationListener() {
+    Config& config = Config::getInstance();
+    conn_str_ = DatabasePool::connectionString(config.get("DB_HOST"), config.get("DB_PORT"));
+    channel_ = config.get("DB_NOTIFY_CHANNEL");
+    batch_ms_ = std::max(0, config.getInt("DB_NOTIFY_BATCH_MS", 50));
+
+    if (pipe(wake_fds_) != 0) {
+        throw std::runtime_error("InvalidationListener(): failed to create wake-up pipe");
+    }
+    fcntl(wake_fds_[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_fds_[1], F_SETFL, O_NONBLOCK);
+}
+
+InvalidationListener::~InvalidationListener() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake();
+    if (listen_thread_.joinable()) {
+        listen_thread_.join();
+    }
+    close(wake_fds_[0]);
+    close(wake_fds_[1]);
+}
+
+int InvalidationListener::subscribe(const std::string& table, BatchHandler on_batch, ResetHandler on_reset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int id = next_subscription_++;
+    subscriptions_[id] = Subscription{table, std::move(on_batch), std::move(on_reset)};
+
+    if (!listen_thread_.joinable()) {
+        listen_thread_ = std::thread([this] { listenLoop(); });
+    }
+    return id;
+}
+
+void InvalidationListener::unsubscribe(int subscription) {
+    // handlers run under mutex_, so none of this subscription's is running after this returns
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscriptions_.erase(subscription);
+}
+
+std::uint64_t InvalidationListener::notificationsReceived() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return notifications_;
+}
+
+std::uint64_t InvalidationListener::batchesApplied() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return batches_;
+}
+
+std::uint64_t InvalidationListener::resets() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return resets_;
+}
+
+void InvalidationListener::wake() {
+    const char byte = 1;
+    [[maybe_unused]] auto written = write(wake_fds_[1], &byte, 1);
+}
+
+bool InvalidationListener::connect() {
+    conn_ = PQconnectdb(conn_str_.c_str());
+    if (PQstatus(conn_) != CONNECTION_OK) {
+        std::cerr << "Error in InvalidationListener::connect(): " << PQerrorMessage(conn_) << std::endl;
+        disconnect();
+        return false;
+    }
+
+    char* channel = PQescapeIdentifier(conn_, channel_.c_str(), channel_.size());
+    std::string listen = std::string("LISTEN ") + (channel != nullptr ? channel : "");
+    PQfreemem(channel);
+
+    PGresult* result = PQexec(conn_, listen.c_str());
+    bool ok = PQresultStatus(result) == PGRES_COMMAND_OK;
+    if (!ok) {
+        std::cerr << "Error in InvalidationListener::connect(): " << PQresultErrorMessage(result) << std::endl;
+    }
+    PQclear(result);
+
+    if (!ok) {
+        disconnect();
+    }
+    return ok;
+}
+
+void InvalidationListener::disconnect() {
+    if (conn_ != nullptr) {
+        PQfinish(conn_);
+        conn_ = nullptr;
+    }
+}
+
+/*
+Drain pending notifications, payload "<table>:<id>" or "<table>:*"; anything else is ignored
+*/
+void InvalidationListener::collect(PendingBatch& pending) {
+    std::uint64_t received = 0;
+    while (PGnotify* notify = PQnotifies(conn_)) {
+        std::string_view payload(notify->extra != nullptr ? notify->extra : "");
+        auto colon = payload.rfind(':');
+        int id = 0;
+        if (colon != std::string_view::npos) {
+            std::string table(payload.substr(0, colon));
+            auto [ptr, ec] = std::from_chars(payload.data() + colon + 1, payload.data() + payload.size(), id);
+            if (payload.substr(colon + 1) == "*") {
+                pending.cleared.insert(std::move(table));
+            }
+            else if (ec == std::errc() && ptr == payload.data() + payload.size()) {
+                pending.ids[std::move(table)].insert(id);
+            }
+        }
+        PQfreemem(notify);
+        received++;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    notifications_ += received;
+}
+
+void InvalidationListener::apply(PendingBatch& pending) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& table : pending.cleared) {
+        for (auto& [id, subscription] : subscriptions_) {
+            if (subscription.table != table || !subscription.on_reset) {
+                continue;
+            }
+            try {
+                subscription.on_reset();
+            } catch (const std::exception& e) {
+                std::cerr << "Error in InvalidationListener::apply(" << table << ":*): " << e.what() << std::endl;
+            }
+        }
+    }
+    for (auto& [table, ids] : pending.ids) {
+        if (pending.cleared.count(table) != 0) {
+            continue;   // 整表已重置
+        }
+        std::vector<int> batch(ids.begin(), ids.end());
+        for (auto& [id, subscription] : subscriptions_) {
+            if (subscription.table != table || !subscription.on_batch) {
+                continue;
+            }
+            try {
+                subscription.on_batch(batch);
+            } catch (const std::exception& e) {
+                std::cerr << "Error in InvalidationListener::apply(" << table << "): " << e.what() << std::endl;
+            }
+        }
+    }
+    pending.clear();
+    batches_++;
+}
+
+void InvalidationListener::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [id, subscription] : subscriptions_) {
+        if (!subscription.on_reset) {
+            continue;
+        }
+        try {
+            subscription.on_reset();
+        } catch (const std::exception& e) {
+            std::cerr << "Error in InvalidationListener::reset(): " << e.what() << std::endl;
+        }
+    }
+    resets_++;
+}
+
+void InvalidationListener::listenLoop() {
+    using clock = std::chrono::steady_clock;
+    const int retry_ms = 1000 * std::max(1, Config::getInstance().getInt("DB_NOTIFY_RETRY_SEC", 5));
+
+    PendingBatch pending;
+    clock::time_point batch_started;
+
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) {
+                break;
+            }
+        }
+
+        if (conn_ == nullptr) {
+            if (!connect()) {
+                pollfd wake_fd{wake_fds_[0], POLLIN, 0};
+                poll(&wake_fd, 1, retry_ms);
+                continue;
+            }
+            // 断线期间的通知已经丢失, 订阅者全部重新加载
+            pending.clear();
+            reset();
+        }
+
+        int timeout = -1;
+        if (!pending.empty()) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - batch_started);
+            timeout = std::max(0, batch_ms_ - static_cast<int>(elapsed.count()));
+        }
+
+        pollfd fds[2] = {{wake_fds_[0], POLLIN, 0}, {PQsocket(conn_), POLLIN, 0}};
+        if (poll(fds, 2, timeout) < 0) {
+            continue;   // EINTR
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char buffer[64];
+            while (read(wake_fds_[0], buffer, sizeof(buffer)) > 0) {
+            }
+        }
+
+        if (fds[1].revents & (POLLIN | POLLERR | POLLHUP)) {
+            if (!PQconsumeInput(conn_) || PQstatus(conn_) != CONNECTION_OK) {
+                std::cerr << "Error in InvalidationListener::listenLoop(): " << PQerrorMessage(conn_) << std::endl;
+                disconnect();
+                continue;
+            }
+            bool was_empty = pending.empty();
+            collect(pending);
+            if (was_empty && !pending.empty()) {
+                batch_started = clock::now();
+            }
+        }
+
+        if (!pending.empty() && clock::now() - batch_started >= std::chrono::milliseconds(batch_ms_)) {
+            apply(pending);
+        }
+    }
+
+    disconnect();
+}